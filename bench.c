@@ -0,0 +1,711 @@
+/**
+ * 𝓞(n³) implementation of the Hungarian algorithm
+ * 
+ * Copyright (C) 2011, 2014, 2020  Mattias Andrée
+ * 
+ * This program is free software. It comes without any warranty, to
+ * the extent permitted by applicable law. You can redistribute it
+ * and/or modify it under the terms of the Do What The Fuck You Want
+ * To Public License, Version 2, as published by Sam Hocevar. See
+ * http://sam.zoy.org/wtfpl/COPYING for more details.
+ */
+
+
+#include "hungarian.h"
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#if defined(__linux__)
+# include <linux/perf_event.h>
+# include <sys/ioctl.h>
+# include <sys/syscall.h>
+#endif
+
+
+/*
+ * Each size is measured in a child process, so that its peak
+ * resident set size is not shadowed by an earlier, larger size,
+ * and the allocations made by the library are counted by linking
+ * with `-Wl,--wrap=malloc` (and likewise for calloc, realloc,
+ * and posix_memalign).
+ * 
+ * With -p, hardware counters are read, with perf_event_open(2),
+ * when each phase of kuhn_solve begins and ends. Only user space
+ * is counted, so that an unprivileged user can open the counters
+ * with the default kernel.perf_event_paranoid setting.
+ * 
+ * The rescan column is the fraction of the tiles updated by
+ * kuhn_solve whose minimum had to be scanned again rather than
+ * carried from the previous update; 1 would be a full pass for
+ * the minimum before every update. The Makefile links the
+ * benchmark with its own build of kuhn.c, with HUNGARIAN_TILE
+ * set to BENCH_TILE, smaller than the library's default so that
+ * the tables that are solved within the time cap span several
+ * tiles.
+ */
+
+
+#define MAX_REPS  1000
+
+#define NCOUNTERS  5
+
+
+/**
+ * Generates a cost
+ *
+ * @param   state  The random number generator's state
+ * @param   i      The row of the cell
+ * @param   j      The column of the cell
+ * @return         The cost of the cell
+ */
+typedef Cell Distribution(uint64_t *state, size_t i, size_t j);
+
+
+/**
+ * The measurements for one size, sent from the child process
+ */
+typedef struct {
+	/**
+	 * The number of repetitions, 0 if the first
+	 * repetition did not finish within the time cap
+	 */
+	size_t reps;
+
+	/**
+	 * The time of each repetition, in seconds
+	 */
+	double times[MAX_REPS];
+
+	/**
+	 * The number of allocations made by one solve
+	 */
+	size_t allocs;
+
+	/**
+	 * The number of bytes allocated by one solve
+	 */
+	size_t bytes;
+
+	/**
+	 * The peak resident set size, in kibibytes
+	 */
+	long int peak_rss;
+
+	/**
+	 * The peak resident set size before the first solve, in kibibytes
+	 */
+	long int base_rss;
+
+	/**
+	 * The number of solves the hardware counters
+	 * were read for, 0 if they were not read
+	 */
+	size_t counted_solves;
+
+	/**
+	 * The number of table tiles updated, over all repetitions
+	 */
+	uint64_t tiles_updated;
+
+	/**
+	 * The number of those tiles whose minimum was
+	 * rescanned rather than carried, over all repetitions
+	 */
+	uint64_t tiles_scanned;
+
+	/**
+	 * Whether each hardware counter could be opened
+	 */
+	Boolean counter_opened[NCOUNTERS];
+
+	/**
+	 * The total of each hardware counter in each phase
+	 */
+	uint64_t counters[KUHN_PHASE_COUNT][NCOUNTERS];
+} Measurement;
+
+
+/**
+ * Open hardware counters
+ */
+typedef struct {
+	/**
+	 * The file descriptor of the group leader, -1 if not opened
+	 */
+	int leader;
+
+	/**
+	 * The file descriptor of each counter, -1 if not opened
+	 */
+	int fds[NCOUNTERS];
+
+	/**
+	 * The position of each opened counter in the group
+	 */
+	size_t index[NCOUNTERS];
+
+	/**
+	 * The value of each counter when the current phase began
+	 */
+	uint64_t begin[NCOUNTERS];
+
+	/**
+	 * Where the counts are added
+	 */
+	Measurement *out;
+} Counters;
+
+
+static size_t allocs = 0;
+static size_t bytes = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+int __real_posix_memalign(void **memptr, size_t alignment, size_t size);
+
+void *
+__wrap_malloc(size_t size)
+{
+	allocs += 1;
+	bytes += size;
+	return __real_malloc(size);
+}
+
+void *
+__wrap_calloc(size_t nmemb, size_t size)
+{
+	allocs += 1;
+	bytes += nmemb * size;
+	return __real_calloc(nmemb, size);
+}
+
+void *
+__wrap_realloc(void *ptr, size_t size)
+{
+	allocs += 1;
+	bytes += size;
+	return __real_realloc(ptr, size);
+}
+
+int
+__wrap_posix_memalign(void **memptr, size_t alignment, size_t size)
+{
+	allocs += 1;
+	bytes += size;
+	return __real_posix_memalign(memptr, alignment, size);
+}
+
+
+/**
+ * SplitMix64 pseudorandom number generator
+ *
+ * @param   state  The generator's state
+ * @return         The next number
+ */
+static uint64_t
+next(uint64_t *state)
+{
+	uint64_t z = (*state += UINT64_C(0x9E3779B97F4A7C15));
+	z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+	z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+	return z ^ (z >> 31);
+}
+
+
+static Cell
+uniform(uint64_t *state, size_t i, size_t j)
+{
+	(void) i, (void) j;
+	return (Cell)(next(state) >> 33);
+}
+
+static Cell
+narrow(uint64_t *state, size_t i, size_t j)
+{
+	(void) i, (void) j;
+	return (Cell)(next(state) & 63);
+}
+
+static Cell
+ties(uint64_t *state, size_t i, size_t j)
+{
+	uint64_t r = next(state);
+	(void) i, (void) j;
+	return (r & 3) ? 0 : (Cell)(r >> 2 & 7);
+}
+
+static Cell
+geometric(uint64_t *state, size_t i, size_t j)
+{
+	double x = (double)((next(state) >> 11) + 1) / 9007199254740993.;
+	(void) i, (void) j;
+	return (Cell)(log(x) / log(0.99));
+}
+
+static Cell
+machol_wien(uint64_t *state, size_t i, size_t j)
+{
+	(void) state;
+	return (Cell)((i + 1) * (j + 1));
+}
+
+
+static const struct {
+	const char *name;
+	Distribution *generate;
+} distributions[] = {
+	{"uniform",   uniform},
+	{"narrow",    narrow},
+	{"ties",      ties},
+	{"geometric", geometric},
+	{"machol",    machol_wien}
+};
+
+static const size_t sizes[] = {8, 16, 32, 64, 128, 256, 512, 1000, 2000, 5000, 10000};
+
+static const char *const counter_names[NCOUNTERS] = {
+	"cycles", "instructions", "L1d-misses", "LLC-misses", "br-misses"
+};
+
+static const char *const phase_names[KUHN_PHASE_COUNT] = {
+	[KUHN_PHASE_REDUCE]           = "reduce_rows",
+	[KUHN_PHASE_MARK]             = "mark",
+	[KUHN_PHASE_IS_DONE]          = "is_done",
+	[KUHN_PHASE_FIND_PRIME]       = "find_prime",
+	[KUHN_PHASE_ADD_AND_SUBTRACT] = "add_and_subtract",
+	[KUHN_PHASE_ALT_MARKS]        = "alt_marks",
+	[KUHN_PHASE_ASSIGN]           = "assign"
+};
+
+static Boolean use_counters = 0;
+
+/**
+ * The allocator of the table and of the solver's memory,
+ * `NULL` for malloc(3), see `-P` and `-H`
+ */
+static const KuhnAllocator *page_allocator = NULL;
+
+
+/**
+ * Opens the hardware counters, as one group
+ *
+ * @param   this  Output parameter for the counters
+ * @param   out   Where the counts shall be added
+ * @return        0 on success, -1 if no counter could be opened
+ */
+static int
+counters_open(Counters *this, Measurement *out)
+{
+	size_t c, nopened = 0;
+
+	this->leader = -1;
+	this->out = out;
+	for (c = 0; c < NCOUNTERS; c++)
+		this->fds[c] = -1;
+
+#if defined(__linux__)
+	{
+		static const struct {
+			uint32_t type;
+			uint64_t config;
+		} events[NCOUNTERS] = {
+			{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+			{PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+			{PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+			                     PERF_COUNT_HW_CACHE_OP_READ << 8 |
+			                     PERF_COUNT_HW_CACHE_RESULT_MISS << 16},
+			{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+			{PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}
+		};
+		struct perf_event_attr attr;
+
+		for (c = 0; c < NCOUNTERS; c++) {
+			memset(&attr, 0, sizeof(attr));
+			attr.size = sizeof(attr);
+			attr.type = events[c].type;
+			attr.config = events[c].config;
+			attr.disabled = this->leader < 0;
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			attr.read_format = PERF_FORMAT_GROUP;
+			this->fds[c] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, this->leader, 0UL);
+			if (this->fds[c] < 0)
+				continue;
+			if (this->leader < 0)
+				this->leader = this->fds[c];
+			this->index[c] = nopened++;
+			out->counter_opened[c] = 1;
+		}
+
+		if (this->leader >= 0)
+			ioctl(this->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	}
+#endif
+
+	return nopened ? 0 : -1;
+}
+
+
+/**
+ * Reads the hardware counters at the beginning and end of each phase
+ *
+ * @param  data   The counters
+ * @param  phase  The phase
+ * @param  begin  Whether the phase begins
+ */
+static void
+counters_hook(void *data, KuhnPhase phase, Boolean begin)
+{
+	Counters *this = data;
+	uint64_t values[1 + NCOUNTERS], value;
+	size_t c;
+
+	if (read(this->leader, values, sizeof(values)) < (ssize_t)sizeof(*values))
+		return;
+
+	for (c = 0; c < NCOUNTERS; c++) {
+		if (this->fds[c] < 0)
+			continue;
+		value = values[1 + this->index[c]];
+		if (begin)
+			this->begin[c] = value;
+		else
+			this->out->counters[phase][c] += value - this->begin[c];
+	}
+}
+
+
+/**
+ * Closes the hardware counters
+ *
+ * @param  this  The counters
+ */
+static void
+counters_close(Counters *this)
+{
+	size_t c;
+	for (c = NCOUNTERS; c--;)
+		if (this->fds[c] >= 0)
+			close(this->fds[c]);
+}
+
+
+static int
+compare_doubles(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+	return x < y ? -1 : x > y;
+}
+
+
+static double
+seconds(const struct timespec *start, const struct timespec *end)
+{
+	return (double)(end->tv_sec - start->tv_sec) + (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+
+/**
+ * Measures one size, in the child process
+ *
+ * @param  n         The height of the table
+ * @param  m         The width of the table
+ * @param  generate  The cost distribution
+ * @param  seed      The seed for the cost distribution
+ * @param  reps      The maximum number of repetitions
+ * @param  cap       The time cap, in seconds, for all repetitions
+ * @param  out       Output parameter for the measurements
+ */
+static void
+measure(size_t n, size_t m, Distribution *generate, uint64_t seed,
+        size_t reps, double cap, Measurement *out)
+{
+	Cell **orig, **table, *cells = NULL;
+	struct timespec start, end, deadline;
+	struct rusage usage;
+	KuhnOptions options = {0};
+	KuhnResult result;
+	KuhnStats stats = {0};
+	Counters counters;
+	double total = 0;
+	size_t i, j;
+
+	memset(out, 0, sizeof(*out));
+
+	orig  = malloc(n * sizeof(*orig));
+	table = malloc(n * sizeof(*table));
+	if (!orig || !table)
+		exit(1);
+	/* The table is not touched until it is copied from
+	 * `orig`, by this thread, which also solves it */
+	if (page_allocator) {
+		cells = page_allocator->allocate(page_allocator->data, n * m * sizeof(Cell) + 1, sizeof(Cell));
+		if (!cells)
+			exit(1);
+		options.allocator = page_allocator;
+	}
+	for (i = 0; i < n; i++) {
+		orig[i]  = malloc(m * sizeof(Cell));
+		table[i] = cells ? &cells[i * m] : malloc(m * sizeof(Cell));
+		if (!orig[i] || !table[i])
+			exit(1);
+		for (j = 0; j < m; j++)
+			orig[i][j] = generate(&seed, i, j);
+	}
+
+	getrusage(RUSAGE_SELF, &usage);
+	out->base_rss = usage.ru_maxrss;
+
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+	deadline.tv_sec += (time_t)cap;
+	deadline.tv_nsec += (long int)((cap - (double)(time_t)cap) * 1e9);
+	if (deadline.tv_nsec >= 1000000000L) {
+		deadline.tv_sec  += 1;
+		deadline.tv_nsec -= 1000000000L;
+	}
+	options.deadline = &deadline;
+	options.stats = &stats;
+
+	if (use_counters && !counters_open(&counters, out)) {
+		options.phase_hook = counters_hook;
+		options.phase_hook_data = &counters;
+	}
+
+	for (out->reps = 0; out->reps < reps && total < cap;) {
+		for (i = 0; i < n; i++)
+			memcpy(table[i], orig[i], m * sizeof(Cell));
+
+		allocs = bytes = 0;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		if (kuhn_solve(n, m, table, &options, &result))
+			exit(1);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		out->allocs = allocs;
+		out->bytes = bytes;
+		out->counted_solves += options.phase_hook != NULL;
+		/* kuhn_solve resets the counters on every call */
+		out->tiles_updated += stats.tiles_updated;
+		out->tiles_scanned += stats.tiles_scanned;
+
+		kuhn_result_destroy(&result);
+		if (!result.optimal)
+			break;
+		out->times[out->reps++] = seconds(&start, &end);
+		total += seconds(&start, &end);
+	}
+
+	if (options.phase_hook)
+		counters_close(&counters);
+
+	getrusage(RUSAGE_SELF, &usage);
+	out->peak_rss = usage.ru_maxrss;
+}
+
+
+/**
+ * Prints the hardware counters, per solve, for each phase
+ *
+ * @param  measurement  The measurements
+ */
+static void
+print_counters(const Measurement *measurement)
+{
+	size_t p, c;
+
+	printf("    %-17s", "phase");
+	for (c = 0; c < NCOUNTERS; c++)
+		printf(" %14s", counter_names[c]);
+	printf("\n");
+
+	for (p = 0; p < KUHN_PHASE_COUNT; p++) {
+		printf("    %-17s", phase_names[p]);
+		for (c = 0; c < NCOUNTERS; c++) {
+			if (measurement->counter_opened[c])
+				printf(" %14.0f", (double)measurement->counters[p][c] / (double)measurement->counted_solves);
+			else
+				printf(" %14s", "-");
+		}
+		printf("\n");
+	}
+}
+
+
+/**
+ * Measures one size in a child process
+ *
+ * @param   n         The height of the table
+ * @param   m         The width of the table
+ * @param   generate  The cost distribution
+ * @param   seed      The seed for the cost distribution
+ * @param   reps      The maximum number of repetitions
+ * @param   cap       The time cap, in seconds, for all repetitions
+ * @param   out       Output parameter for the measurements
+ * @return            0 on success, -1 on error
+ */
+static int
+run(size_t n, size_t m, Distribution *generate, uint64_t seed,
+    size_t reps, double cap, Measurement *out)
+{
+	int fds[2], status;
+	pid_t pid;
+	size_t off = 0;
+	ssize_t r;
+
+	if (pipe(fds))
+		return -1;
+
+	pid = fork();
+	if (pid < 0)
+		return -1;
+	if (!pid) {
+		close(fds[0]);
+		measure(n, m, generate, seed, reps, cap, out);
+		for (; off < sizeof(*out); off += (size_t)r)
+			if ((r = write(fds[1], (char *)out + off, sizeof(*out) - off)) < 0)
+				_exit(1);
+		_exit(0);
+	}
+
+	close(fds[1]);
+	while (off < sizeof(*out)) {
+		r = read(fds[0], (char *)out + off, sizeof(*out) - off);
+		if (r <= 0) {
+			if (r < 0 && errno == EINTR)
+				continue;
+			break;
+		}
+		off += (size_t)r;
+	}
+	close(fds[0]);
+
+	if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) || off < sizeof(*out))
+		return -1;
+	return 0;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+	static Measurement measurement;
+	Counters counters;
+	const char *only = NULL;
+	uint64_t seed = 1;
+	size_t reps = 11, d, s, shape, n, m;
+	double cap = 5, median, p99;
+	Boolean capped[2];
+	int opt, placement = -1, huge = 0;
+
+	while ((opt = getopt(argc, argv, "HP:c:d:pr:s:")) != -1) {
+		switch (opt) {
+		case 'H':
+			huge = KUHN_PAGES_HUGE;
+			break;
+		case 'P':
+			if (!strcmp(optarg, "malloc"))
+				placement = -1;
+			else if (!strcmp(optarg, "local"))
+				placement = 0;
+			else if (!strcmp(optarg, "interleave"))
+				placement = KUHN_PAGES_INTERLEAVE;
+			else
+				goto usage;
+			break;
+		case 'c':
+			cap = atof(optarg);
+			break;
+		case 'd':
+			only = optarg;
+			break;
+		case 'p':
+			use_counters = 1;
+			break;
+		case 'r':
+			reps = (size_t)atol(optarg);
+			if (reps < 1 || reps > MAX_REPS)
+				goto usage;
+			break;
+		case 's':
+			seed = (uint64_t)strtoull(optarg, NULL, 0);
+			break;
+		default:
+			goto usage;
+		}
+	}
+	if (optind != argc)
+		goto usage;
+	if (placement >= 0 || huge)
+		page_allocator = kuhn_page_allocator((placement > 0 ? placement : 0) | huge);
+
+	if (use_counters) {
+		if (counters_open(&counters, &measurement)) {
+			fprintf(stderr, "%s: hardware counters are unavailable: perf_event_open: %s\n",
+			        argv[0], strerror(errno));
+			use_counters = 0;
+		}
+		counters_close(&counters);
+		memset(&measurement, 0, sizeof(measurement));
+	}
+
+#if defined(HUNGARIAN_TILE)
+	printf("kuhn_solve built with HUNGARIAN_TILE = %li bytes\n\n", (long int)(HUNGARIAN_TILE));
+#endif
+	printf("%-10s %6s %6s %5s %12s %12s %9s %12s %10s %10s %7s\n", "dist", "n", "m", "reps",
+	       "median (ms)", "p99 (ms)", "allocs", "bytes", "rss (KiB)", "+rss (KiB)", "rescan");
+
+	for (d = 0; d < sizeof(distributions) / sizeof(*distributions); d++) {
+		if (only && strcmp(only, distributions[d].name))
+			continue;
+		capped[0] = capped[1] = 0;
+		for (s = 0; s < sizeof(sizes) / sizeof(*sizes); s++) {
+			for (shape = 0; shape < 2; shape++) {
+				/* Square, and twice as wide as high */
+				n = shape ? sizes[s] / 2 : sizes[s];
+				m = sizes[s];
+				if (capped[shape])
+					continue;
+
+				if (run(n, m, distributions[d].generate, seed ^ ((uint64_t)d << 48 ^ (uint64_t)n << 24 ^ m),
+				        reps, cap, &measurement)) {
+					fprintf(stderr, "%s: measurement of %zu×%zu failed\n", argv[0], n, m);
+					return 1;
+				}
+
+				if (!measurement.reps) {
+					printf("%-10s %6zu %6zu  (did not finish in %g s)\n", distributions[d].name, n, m, cap);
+					capped[shape] = 1;
+					continue;
+				}
+
+				qsort(measurement.times, measurement.reps, sizeof(double), compare_doubles);
+				median = measurement.times[measurement.reps / 2];
+				p99 = measurement.times[(measurement.reps * 99 + 99) / 100 - 1];
+				printf("%-10s %6zu %6zu %5zu %12.3f %12.3f %9zu %12zu %10li %10li",
+				       distributions[d].name, n, m, measurement.reps, median * 1000, p99 * 1000,
+				       measurement.allocs, measurement.bytes, measurement.peak_rss,
+				       measurement.peak_rss - measurement.base_rss);
+				if (measurement.tiles_updated)
+					printf(" %7.3f\n", (double)measurement.tiles_scanned / (double)measurement.tiles_updated);
+				else
+					printf(" %7s\n", "-");
+				if (measurement.counted_solves)
+					print_counters(&measurement);
+				fflush(stdout);
+			}
+		}
+	}
+
+	return 0;
+
+usage:
+	fprintf(stderr, "usage: %s [-c seconds] [-d distribution] [-p] [-r repetitions] [-s seed] "
+	        "[-P malloc | local | interleave] [-H]\n", argv[0]);
+	return 1;
+}
@@ -0,0 +1,274 @@
+/**
+ * 𝓞(n³) implementation of the Hungarian algorithm
+ * 
+ * Copyright (C) 2011, 2014, 2020  Mattias Andrée
+ * 
+ * This program is free software. It comes without any warranty, to
+ * the extent permitted by applicable law. You can redistribute it
+ * and/or modify it under the terms of the Do What The Fuck You Want
+ * To Public License, Version 2, as published by Sam Hocevar. See
+ * http://sam.zoy.org/wtfpl/COPYING for more details.
+ */
+
+
+
+#include "common.h"
+
+
+/*
+ * The cached rows are kept in slots that are linked from the most
+ * to the least recently used, and each row of the table records
+ * its slot, so finding a row, and moving it to the front, takes
+ * constant time. Everything is allocated once, with the cache.
+ */
+
+
+/**
+ * Index stored for rows that are not cached,
+ * and for the ends of the list of slots
+ */
+#define NONE  ((KuhnIndex)-1)
+
+
+struct kuhn_row_cache {
+	/**
+	 * The allocator the cache was allocated with
+	 */
+	const KuhnAllocator *allocator;
+
+	/**
+	 * The size of the allocation
+	 */
+	size_t size;
+
+	/**
+	 * Function that fetches a row of the table
+	 */
+	KuhnRowFunction *get_row;
+
+	/**
+	 * First argument for `get_row`
+	 */
+	void *data;
+
+	/**
+	 * The width of the table
+	 */
+	size_t m;
+
+	/**
+	 * The number of slots
+	 */
+	size_t capacity;
+
+	/**
+	 * The number of slots that have been used
+	 */
+	size_t used;
+
+	/**
+	 * The most recently used slot, `NONE` if none is
+	 */
+	KuhnIndex head;
+
+	/**
+	 * The least recently used slot, `NONE` if none is
+	 */
+	KuhnIndex tail;
+
+	/**
+	 * The number of rows found in the cache
+	 */
+	uint_fast64_t hits;
+
+	/**
+	 * The number of rows fetched into the cache
+	 */
+	uint_fast64_t misses;
+
+	/**
+	 * The cells of the slots, `m` per slot
+	 */
+	Cell *cells;
+
+	/**
+	 * The slot of each row of the table, `NONE` if it is not cached
+	 */
+	KuhnIndex *slot_of_row;
+
+	/**
+	 * The row in each slot, `NONE` if it is empty
+	 */
+	KuhnIndex *row_of_slot;
+
+	/**
+	 * The next more recently used slot of each slot
+	 */
+	KuhnIndex *prev;
+
+	/**
+	 * The next less recently used slot of each slot
+	 */
+	KuhnIndex *next;
+};
+
+
+/**
+ * Removes a slot from the list of slots
+ *
+ * @param  this  The cache
+ * @param  slot  The slot
+ */
+static void
+unlink_slot(KuhnRowCache *this, KuhnIndex slot)
+{
+	if (this->prev[slot] == NONE)
+		this->head = this->next[slot];
+	else
+		this->next[this->prev[slot]] = this->next[slot];
+	if (this->next[slot] == NONE)
+		this->tail = this->prev[slot];
+	else
+		this->prev[this->next[slot]] = this->prev[slot];
+}
+
+
+/**
+ * Inserts a slot into the list of slots,
+ * as the most recently used slot
+ *
+ * @param  this  The cache
+ * @param  slot  The slot
+ */
+static void
+push_slot(KuhnRowCache *this, KuhnIndex slot)
+{
+	this->prev[slot] = NONE;
+	this->next[slot] = this->head;
+	if (this->head == NONE)
+		this->tail = slot;
+	else
+		this->prev[this->head] = slot;
+	this->head = slot;
+}
+
+
+KuhnRowCache *
+kuhn_row_cache_create(size_t n, size_t m, size_t capacity, KuhnRowFunction *get_row,
+                      void *data, const KuhnAllocator *allocator)
+{
+	size_t header = (sizeof(KuhnRowCache) + sizeof(Cell) - 1) / sizeof(Cell) * sizeof(Cell);
+	size_t size, i;
+	KuhnRowCache *this;
+	char *block;
+
+	if (!allocator)
+		allocator = &kuhn_default_allocator;
+	if (capacity > n)
+		capacity = n;
+	if (!capacity || !m) {
+		errno = EINVAL;
+		return NULL;
+	}
+	if (n >= NONE || capacity > (SIZE_MAX - header) / 2 / m / sizeof(Cell) ||
+	    n + 3 * capacity > (SIZE_MAX / 2 - header) / sizeof(KuhnIndex)) {
+		errno = ENOMEM;
+		return NULL;
+	}
+	size = header + capacity * m * sizeof(Cell) + (n + 3 * capacity) * sizeof(KuhnIndex);
+
+	if (!(block = kuhn_allocate(allocator, size, sizeof(Cell))))
+		return NULL;
+	this = (KuhnRowCache *)(void *)block;
+	this->allocator   = allocator;
+	this->size        = size;
+	this->get_row     = get_row;
+	this->data        = data;
+	this->m           = m;
+	this->capacity    = capacity;
+	this->used        = 0;
+	this->head        = NONE;
+	this->tail        = NONE;
+	this->hits        = 0;
+	this->misses      = 0;
+	this->cells       = (Cell *)(void *)&block[header];
+	this->slot_of_row = (KuhnIndex *)(void *)&this->cells[capacity * m];
+	this->row_of_slot = &this->slot_of_row[n];
+	this->prev        = &this->row_of_slot[capacity];
+	this->next        = &this->prev[capacity];
+
+	for (i = 0; i < n; i++)
+		this->slot_of_row[i] = NONE;
+	return this;
+}
+
+
+const Cell *
+kuhn_row_cache_fetch(void *cache, size_t row, Cell *buf)
+{
+	KuhnRowCache *this = cache;
+	KuhnIndex slot = this->slot_of_row[row];
+	const Cell *cells;
+	Cell *dest;
+
+	(void) buf;
+
+	if (slot != NONE) {
+		this->hits += 1;
+		if (slot != this->head) {
+			unlink_slot(this, slot);
+			push_slot(this, slot);
+		}
+		return &this->cells[(size_t)slot * this->m];
+	}
+
+	/* An empty slot, or else the least recently used, which
+	 * is emptied first, so that it is empty if fetching fails */
+	if (this->used < this->capacity) {
+		slot = (KuhnIndex)this->used++;
+	} else {
+		slot = this->tail;
+		unlink_slot(this, slot);
+		if (this->row_of_slot[slot] != NONE)
+			this->slot_of_row[this->row_of_slot[slot]] = NONE;
+	}
+	this->row_of_slot[slot] = NONE;
+
+	dest = &this->cells[(size_t)slot * this->m];
+	cells = this->get_row(this->data, row, dest);
+	if (!cells) {
+		/* Reused first, as the least recently used */
+		this->prev[slot] = this->tail;
+		this->next[slot] = NONE;
+		if (this->tail == NONE)
+			this->head = slot;
+		else
+			this->next[this->tail] = slot;
+		this->tail = slot;
+		return NULL;
+	}
+	if (cells != dest)
+		memcpy(dest, cells, this->m * sizeof(Cell));
+
+	this->misses += 1;
+	this->row_of_slot[slot] = (KuhnIndex)row;
+	this->slot_of_row[row] = slot;
+	push_slot(this, slot);
+	return dest;
+}
+
+
+void
+kuhn_row_cache_stats(const KuhnRowCache *this, uint_fast64_t *hitsp, uint_fast64_t *missesp)
+{
+	*hitsp = this->hits;
+	*missesp = this->misses;
+}
+
+
+void
+kuhn_row_cache_destroy(KuhnRowCache *this)
+{
+	if (this)
+		kuhn_deallocate(this->allocator, this, this->size, sizeof(Cell));
+}
@@ -0,0 +1,235 @@
+/**
+ * 𝓞(n³) implementation of the Hungarian algorithm
+ * 
+ * Copyright (C) 2011, 2014, 2020  Mattias Andrée
+ * 
+ * This program is free software. It comes without any warranty, to
+ * the extent permitted by applicable law. You can redistribute it
+ * and/or modify it under the terms of the Do What The Fuck You Want
+ * To Public License, Version 2, as published by Sam Hocevar. See
+ * http://sam.zoy.org/wtfpl/COPYING for more details.
+ */
+
+
+#include "hungarian.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#if defined(__GNUC__)
+# define HIDDEN __attribute__((__visibility__("hidden")))
+#else
+# define HIDDEN
+#endif
+
+
+/*
+ * The performance counters are only compiled in with
+ * -DHUNGARIAN_STATS, so that they cost nothing otherwise
+ */
+#if defined(HUNGARIAN_STATS)
+# define STAT(stats, field, amount)\
+	((stats) ? (void)((stats)->field += (uint_fast64_t)(amount)) : (void)0)
+#else
+# define STAT(stats, field, amount)  ((void)(stats))
+#endif
+
+
+/**
+ * Cover set, one bit per row or column, packed into limbs
+ * so that 64 rows or columns can be tested at once; bits
+ * past the last row or column are always clear
+ */
+typedef uint64_t Cover;
+
+/**
+ * The number of limbs in a cover set of `count` bits
+ */
+#define COVER_LIMBS(count)  (((count) + 63) >> 6)
+
+/**
+ * Whether row or column `i` is covered
+ */
+#define COVERED(cover, i)  ((Boolean)((cover)[(i) >> 6] >> ((i) & 63) & 1))
+
+/**
+ * Covers row or column `i`
+ */
+#define COVER(cover, i)  ((cover)[(i) >> 6] |= (Cover)1 << ((i) & 63))
+
+/**
+ * Uncovers row or column `i`
+ */
+#define UNCOVER(cover, i)  ((cover)[(i) >> 6] &= ~((Cover)1 << ((i) & 63)))
+
+/**
+ * Index of the lowest set bit in a non-zero limb
+ */
+#if defined(__GNUC__)
+# define LOWEST_BIT(limb)  ((size_t)__builtin_ctzll(limb))
+#else
+# define LOWEST_BIT(limb)  lb((limb) & -(limb))
+#endif
+
+/**
+ * The bits in limb `b` of a cover set of
+ * `count` bits that are rows or columns
+ */
+#define COVER_VALID(count, b)\
+	((b) + 1 < COVER_LIMBS(count) || !((count) & 63) ? ~(Cover)0 : ((Cover)1 << ((count) & 63)) - 1)
+
+
+#if !defined(__GNUC__)
+/**
+ * Calculates the floored binary logarithm of a positive integer,
+ * used by `LOWEST_BIT` where there is no builtin for it
+ *
+ * @param   value  The integer whose logarithm to calculate
+ * @return         The floored binary logarithm of the integer
+ */
+static inline size_t
+lb(uint64_t value)
+{
+	size_t rc = 0;
+	uint64_t v = value;
+
+	if (v & 0xFFFFFFFF00000000ULL) { rc |= 32L; v >>= 32; }
+	if (v & 0x00000000FFFF0000ULL) { rc |= 16L; v >>= 16; }
+	if (v & 0x000000000000FF00ULL) { rc |=  8L; v >>=  8; }
+	if (v & 0x00000000000000F0ULL) { rc |=  4L; v >>=  4; }
+	if (v & 0x000000000000000CULL) { rc |=  2L; v >>=  2; }
+	if (v & 0x0000000000000002ULL) { rc |=  1L; }
+
+	return rc;
+}
+#endif
+
+
+/**
+ * Cost of a cell that may not be part of the assignment,
+ * recognised by the shortest augmenting path engine
+ */
+#define FORBIDDEN CELL_MAX
+
+
+/**
+ * Fetches a row of costs for the shortest augmenting path engine
+ *
+ * @param   ctx  User-defined data
+ * @param   row  The index of the row
+ * @param   buf  Buffer with room for one row, that
+ *               the function may but need not use
+ * @return       The row's costs, indexed by column
+ */
+typedef const Cell *SapRowFunction(void *ctx, size_t row, Cell *buf);
+
+
+/**
+ * Scratch memory for the shortest augmenting path engine,
+ * each array must have room for every column index in use
+ */
+typedef struct {
+	/**
+	 * The shortest known reduced distance to each column
+	 */
+	Cell *minv;
+
+	/**
+	 * The column preceding each column on its shortest path, -1 for the root
+	 */
+	ssize_t *way;
+
+	/**
+	 * Work list of columns
+	 */
+	size_t *todo;
+
+	/**
+	 * Row buffer passed to the `SapRowFunction`
+	 */
+	Cell *buf;
+} SapScratch;
+
+
+/**
+ * Assigns an unassigned row by augmenting the matching along
+ * a shortest path in the reduced costs (Dijkstra's algorithm
+ * on the dual potentials), keeping the potentials feasible
+ * and every assigned cell tight
+ *
+ * Cells whose cost is `FORBIDDEN` are never used, and if no free
+ * column can be reached the potentials are still feasible but
+ * the matching is left unchanged
+ *
+ * @param   row      The row to assign
+ * @param   ncols    The number of columns that take part
+ * @param   cols     The indices of the columns that take part
+ * @param   u        Row potentials
+ * @param   v        Column potentials
+ * @param   row_col  The column assigned to each row, -1 if unassigned
+ * @param   col_row  The row assigned to each column, -1 if unassigned
+ * @param   scratch  Scratch memory
+ * @param   get_row  Function that fetches the cost of a row
+ * @param   ctx      First argument for `get_row`
+ * @return           0 on success, -1 if no free column is reachable
+ */
+HIDDEN int sap_augment(size_t row, size_t ncols, const size_t *cols, Cell *u, Cell *v,
+                       ssize_t *row_col, ssize_t *col_row, SapScratch *scratch,
+                       SapRowFunction *get_row, void *ctx);
+
+
+/**
+ * The allocator used if none is specified
+ */
+HIDDEN extern const KuhnAllocator kuhn_default_allocator;
+
+/**
+ * Allocates memory
+ *
+ * @param   allocator  The allocator
+ * @param   size       The number of bytes to allocate, 0 is treated as 1
+ * @param   alignment  The required alignment
+ * @return             The memory, `NULL` on failure (errno is `ENOMEM`)
+ */
+HIDDEN void *kuhn_allocate(const KuhnAllocator *allocator, size_t size, size_t alignment);
+
+/**
+ * Deallocates memory
+ *
+ * @param  allocator  The allocator the memory was allocated with
+ * @param  ptr        The memory, may be `NULL`
+ * @param  size       The size passed to `kuhn_allocate`
+ * @param  alignment  The alignment passed to `kuhn_allocate`
+ */
+HIDDEN void kuhn_deallocate(const KuhnAllocator *allocator, void *ptr, size_t size, size_t alignment);
+
+/**
+ * Checks whether a deadline has passed
+ *
+ * @param   deadline  The deadline, on the `CLOCK_MONOTONIC` clock, or `NULL`
+ * @return            Whether the deadline has passed
+ */
+HIDDEN Boolean kuhn_expired(const struct timespec *deadline);
+
+
+/**
+ * Reads the monotonic clock
+ *
+ * @return  The time, in nanoseconds
+ */
+HIDDEN uint_fast64_t kuhn_now(void);
+
+/**
+ * Writes a span to a trace
+ *
+ * The span is put on the track of the calling thread, so
+ * spans from threads that share a trace are not interleaved
+ *
+ * @param  this   The trace
+ * @param  name   The name of the span
+ * @param  start  When the span started, from `kuhn_now`
+ * @param  end    When the span ended, from `kuhn_now`
+ */
+HIDDEN void trace_span(KuhnTrace *this, const char *name, uint_fast64_t start, uint_fast64_t end);
@@ -0,0 +1,478 @@
+/**
+ * 𝓞(n³) implementation of the Hungarian algorithm
+ * 
+ * Copyright (C) 2011, 2014, 2020  Mattias Andrée
+ * 
+ * This program is free software. It comes without any warranty, to
+ * the extent permitted by applicable law. You can redistribute it
+ * and/or modify it under the terms of the Do What The Fuck You Want
+ * To Public License, Version 2, as published by Sam Hocevar. See
+ * http://sam.zoy.org/wtfpl/COPYING for more details.
+ */
+
+
+#if defined(__linux__)
+# define _GNU_SOURCE
+#endif
+
+#include "daemon.h"
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#if defined(__linux__)
+# include <sys/mman.h>
+#endif
+
+
+
+/**
+ * The size of a request, excluding the file descriptor
+ */
+#define REQUEST_SIZE  16
+
+
+/**
+ * State shared by the daemon's threads
+ */
+typedef struct {
+	int listener;
+	const KuhnOptions *options;
+} Daemon;
+
+
+/**
+ * Stores an integer as little-endian
+ *
+ * @param  buf    Output buffer
+ * @param  value  The integer
+ */
+static void
+put_u64(unsigned char *buf, uint64_t value)
+{
+	size_t i;
+
+	for (i = 0; i < 8; i++)
+		buf[i] = (unsigned char)(value >> (i * 8));
+}
+
+
+/**
+ * Loads a little-endian integer
+ *
+ * @param   buf  The integer's bytes
+ * @return       The integer
+ */
+static uint64_t
+get_u64(const unsigned char *buf)
+{
+	uint64_t value = 0;
+	size_t i;
+
+	for (i = 8; i--;)
+		value = value << 8 | buf[i];
+	return value;
+}
+
+
+/**
+ * Writes an entire buffer
+ *
+ * @param   fd    The file to write to
+ * @param   buf   The buffer
+ * @param   size  The size of the buffer
+ * @return        0 on success, -1 on error
+ */
+static int
+write_all(int fd, const unsigned char *buf, size_t size)
+{
+	ssize_t r;
+
+	while (size) {
+		r = write(fd, buf, size);
+		if (r < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		buf += r;
+		size -= (size_t)r;
+	}
+	return 0;
+}
+
+
+/**
+ * Fills a buffer with input
+ *
+ * @param   fd    The file to read from
+ * @param   buf   The buffer
+ * @param   size  The size of the buffer
+ * @return        0 on success, -1 on error,
+ *                `EPROTO` at premature end of input
+ */
+static int
+read_all(int fd, unsigned char *buf, size_t size)
+{
+	ssize_t r;
+
+	while (size) {
+		r = read(fd, buf, size);
+		if (r <= 0) {
+			if (r < 0 && errno == EINTR)
+				continue;
+			if (!r)
+				errno = EPROTO;
+			return -1;
+		}
+		buf += r;
+		size -= (size_t)r;
+	}
+	return 0;
+}
+
+
+/**
+ * Reads a request
+ *
+ * @param   conn     The connection
+ * @param   request  Output buffer for the request
+ * @return           The attached file descriptor, -1 on error
+ */
+static int
+receive_request(int conn, unsigned char request[REQUEST_SIZE])
+{
+	union {
+		char buf[CMSG_SPACE(sizeof(int))];
+		struct cmsghdr align;
+	} control;
+	struct iovec iov = {.iov_base = request, .iov_len = REQUEST_SIZE};
+	struct msghdr msg = {0};
+	struct cmsghdr *cmsg;
+	ssize_t r;
+	int fd = -1;
+
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control.buf;
+	msg.msg_controllen = sizeof(control.buf);
+
+	do {
+		r = recvmsg(conn, &msg, MSG_CMSG_CLOEXEC);
+	} while (r < 0 && errno == EINTR);
+	if (r <= 0) {
+		if (!r)
+			errno = EPROTO;
+		return -1;
+	}
+
+	for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+		if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+		    cmsg->cmsg_len == CMSG_LEN(sizeof(int)))
+			memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+	if (fd < 0 || (msg.msg_flags & MSG_CTRUNC)) {
+		if (fd >= 0)
+			close(fd);
+		errno = EPROTO;
+		return -1;
+	}
+
+	if (read_all(conn, &request[r], REQUEST_SIZE - (size_t)r)) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+
+/**
+ * Reads, solves, and replies to a request
+ *
+ * @param   this  The daemon
+ * @param   conn  The connection
+ * @return        0 on success, -1 if the reply could not be written
+ */
+static int
+handle(Daemon *this, int conn)
+{
+	unsigned char request[REQUEST_SIZE], status[8];
+	KuhnOptions options = *this->options;
+	struct timespec deadline;
+	KuhnResult result;
+	Matrix matrix;
+	uint64_t flags;
+	long int budget;
+	int fd, error = 0, r;
+	FILE *fp;
+
+	if ((fd = receive_request(conn, request)) < 0)
+		return -1;
+	flags = get_u64(&request[0]);
+	budget = (long int)(int64_t)get_u64(&request[8]);
+
+	/* The table is mapped privately, so the pages kuhn_solve reduces,
+	 * in practice all of them, are copied on write and the client's
+	 * memfd is left intact; reading the others is only safe if the
+	 * client cannot shrink the file under the daemon's feet */
+#if defined(__linux__)
+	r = fcntl(fd, F_GET_SEALS);
+	if (r < 0 || !(r & F_SEAL_SHRINK)) {
+		close(fd);
+		error = EPERM;
+		goto reply;
+	}
+#else
+	close(fd);
+	error = ENOSYS;
+	goto reply;
+#endif
+	r = matrix_map_fd(&matrix, fd);
+	close(fd);
+	if (r) {
+		error = errno;
+		goto reply;
+	}
+	if (matrix.n > matrix.m) {
+		matrix_destroy(&matrix);
+		error = EINVAL;
+		goto reply;
+	}
+
+	options.maximize = !!(flags & DAEMON_MAXIMIZE);
+	options.deadline = NULL;
+	if (budget >= 0) {
+		clock_gettime(CLOCK_MONOTONIC, &deadline);
+		deadline.tv_sec  += budget / 1000;
+		deadline.tv_nsec += budget % 1000 * 1000000L;
+		if (deadline.tv_nsec >= 1000000000L) {
+			deadline.tv_sec  += 1;
+			deadline.tv_nsec -= 1000000000L;
+		}
+		options.deadline = &deadline;
+	}
+	if (kuhn_solve(matrix.n, matrix.m, matrix.rows, &options, &result)) {
+		error = errno;
+		matrix_destroy(&matrix);
+		goto reply;
+	}
+
+reply:
+	put_u64(status, (uint64_t)error);
+	if (write_all(conn, status, sizeof(status))) {
+		if (!error) {
+			kuhn_result_destroy(&result);
+			matrix_destroy(&matrix);
+		}
+		return -1;
+	}
+	if (error)
+		return 0;
+
+	r = -1;
+	if ((fd = dup(conn)) >= 0) {
+		if ((fp = fdopen(fd, "wb"))) {
+			r = (flags & DAEMON_BINARY ? assignment_write_binary : assignment_write_text)
+			        (fp, result.col_of_row, matrix.n, result.cost);
+			if (fclose(fp))
+				r = -1;
+		} else {
+			close(fd);
+		}
+	}
+	kuhn_result_destroy(&result);
+	matrix_destroy(&matrix);
+	return r;
+}
+
+
+/**
+ * A thread in the daemon's pool
+ *
+ * @param   data  The daemon
+ * @return        `NULL`
+ */
+static void *
+worker(void *data)
+{
+	Daemon *this = data;
+	int conn;
+
+	for (;;) {
+		conn = accept(this->listener, NULL, NULL);
+		if (conn < 0) {
+			if (errno != EINTR && errno != ECONNABORTED)
+				perror("accept");
+			continue;
+		}
+		handle(this, conn);
+		close(conn);
+	}
+	return NULL;
+}
+
+
+/**
+ * Fills in the address of a Unix socket
+ *
+ * @param   addr  Output parameter for the address
+ * @param   path  The path of the socket
+ * @return        0 on success, -1 if the path is too long
+ */
+static int
+socket_address(struct sockaddr_un *addr, const char *path)
+{
+	memset(addr, 0, sizeof(*addr));
+	addr->sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(addr->sun_path)) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	strcpy(addr->sun_path, path);
+	return 0;
+}
+
+
+int
+daemon_serve(const char *path, size_t nthreads, const KuhnOptions *options)
+{
+	Daemon this = {.options = options};
+	struct sockaddr_un addr;
+	struct stat st;
+	pthread_t thread;
+	size_t i;
+	int saved_errno;
+
+	if (socket_address(&addr, path))
+		return -1;
+	if (!lstat(path, &st) && S_ISSOCK(st.st_mode))
+		unlink(path);
+
+	/* A client that goes away before its reply is written must
+	 * not take the daemon with it */
+	signal(SIGPIPE, SIG_IGN);
+
+	this.listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (this.listener < 0)
+		return -1;
+	if (bind(this.listener, (struct sockaddr *)&addr, sizeof(addr)) ||
+	    listen(this.listener, SOMAXCONN))
+		goto fail;
+
+	for (i = 0; i < (nthreads ? nthreads : 1); i++)
+		if ((errno = pthread_create(&thread, NULL, worker, &this)))
+			goto fail;
+	for (;;)
+		pause();
+
+fail:
+	saved_errno = errno;
+	close(this.listener);
+	errno = saved_errno;
+	return -1;
+}
+
+
+int
+daemon_request(const char *path, const Matrix *matrix, uint64_t flags, long int budget, FILE *output)
+{
+#if defined(__linux__)
+	unsigned char request[REQUEST_SIZE], status[8], buf[BUFSIZ];
+	union {
+		char buf[CMSG_SPACE(sizeof(int))];
+		struct cmsghdr align;
+	} control;
+	struct iovec iov = {.iov_base = request, .iov_len = REQUEST_SIZE};
+	struct msghdr msg = {0};
+	struct cmsghdr *cmsg;
+	struct sockaddr_un addr;
+	int memfd = -1, conn = -1, fd, saved_errno;
+	FILE *fp;
+	ssize_t r;
+
+	if (socket_address(&addr, path))
+		return -1;
+
+	memfd = memfd_create("hungarian", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (memfd < 0)
+		return -1;
+	if ((fd = dup(memfd)) < 0)
+		goto fail;
+	if (!(fp = fdopen(fd, "wb"))) {
+		close(fd);
+		goto fail;
+	}
+	if (matrix_write_fp(matrix, fp)) {
+		saved_errno = errno;
+		fclose(fp);
+		errno = saved_errno;
+		goto fail;
+	}
+	if (fclose(fp) ||
+	    fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL))
+		goto fail;
+
+	conn = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (conn < 0 || connect(conn, (struct sockaddr *)&addr, sizeof(addr)))
+		goto fail;
+
+	put_u64(&request[0], flags);
+	put_u64(&request[8], (uint64_t)(int64_t)budget);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control.buf;
+	msg.msg_controllen = sizeof(control.buf);
+	cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+	memcpy(CMSG_DATA(cmsg), &memfd, sizeof(int));
+
+	do {
+		r = sendmsg(conn, &msg, MSG_NOSIGNAL);
+	} while (r < 0 && errno == EINTR);
+	if (r < 0 || write_all(conn, &request[r], REQUEST_SIZE - (size_t)r))
+		goto fail;
+	close(memfd);
+	memfd = -1;
+
+	if (read_all(conn, status, sizeof(status)))
+		goto fail;
+	if ((errno = (int)get_u64(status)))
+		goto fail;
+	while ((r = read(conn, buf, sizeof(buf)))) {
+		if (r < 0) {
+			if (errno == EINTR)
+				continue;
+			goto fail;
+		}
+		if (fwrite(buf, (size_t)r, 1, output) != 1)
+			goto fail;
+	}
+	close(conn);
+	return fflush(output) ? -1 : 0;
+
+fail:
+	saved_errno = errno;
+	if (memfd >= 0)
+		close(memfd);
+	if (conn >= 0)
+		close(conn);
+	errno = saved_errno;
+	return -1;
+#else
+	(void) path;
+	(void) matrix;
+	(void) flags;
+	(void) budget;
+	(void) output;
+	errno = ENOSYS;
+	return -1;
+#endif
+}
@@ -0,0 +1,76 @@
+/**
+ * 𝓞(n³) implementation of the Hungarian algorithm
+ * 
+ * Copyright (C) 2011, 2014, 2020  Mattias Andrée
+ * 
+ * This program is free software. It comes without any warranty, to
+ * the extent permitted by applicable law. You can redistribute it
+ * and/or modify it under the terms of the Do What The Fuck You Want
+ * To Public License, Version 2, as published by Sam Hocevar. See
+ * http://sam.zoy.org/wtfpl/COPYING for more details.
+ */
+
+
+#ifndef DAEMON_H
+#define DAEMON_H
+
+
+#include "matrix.h"
+
+
+
+/*
+ * The daemon protocol: a client connects to the daemon's Unix
+ * socket, creates a memfd(2) holding the table as a binary matrix
+ * file (see `matrix_map`), seals it against resizing, and sends
+ * a 16-byte request with the memfd attached as SCM_RIGHTS: the
+ * flags (8 bytes, `DAEMON_MAXIMIZE` and `DAEMON_BINARY`) and the
+ * time limit in milliseconds, -1 for none (8 bytes, signed). All
+ * integers are little-endian. The daemon maps the table privately,
+ * solves it, and replies with an errno value (8 bytes,
+ * 0 on success) followed, on success, by the result in the format
+ * of `assignment_write_text` or, with `DAEMON_BINARY`, that of
+ * `assignment_write_binary`, and closes the connection.
+ */
+
+
+/**
+ * Request flag: maximise rather than minimise the cost
+ */
+#define DAEMON_MAXIMIZE  0x0001
+
+/**
+ * Request flag: reply with a binary result
+ */
+#define DAEMON_BINARY    0x0002
+
+
+/**
+ * Serves requests on a Unix socket until the process is killed
+ *
+ * The requests are solved by a pool of threads that are started
+ * up front and each accept and handle one connection at a time
+ *
+ * @param   path      The path of the socket, a stale socket at
+ *                    the path is removed
+ * @param   nthreads  The number of threads
+ * @param   options   Options for `kuhn_solve`, the deadline and
+ *                    maximisation are set per request
+ * @return            -1 on error
+ */
+int daemon_serve(const char *path, size_t nthreads, const KuhnOptions *options);
+
+/**
+ * Sends a table to a daemon and writes its reply
+ *
+ * @param   path    The path of the daemon's socket
+ * @param   matrix  The table
+ * @param   flags   `DAEMON_MAXIMIZE` and `DAEMON_BINARY` or:ed together
+ * @param   budget  The time limit in milliseconds, -1 for no limit
+ * @param   output  The file to write the result to
+ * @return          0 on success, -1 on error
+ */
+int daemon_request(const char *path, const Matrix *matrix, uint64_t flags, long int budget, FILE *output);
+
+
+#endif
@@ -0,0 +1,817 @@
+/**
+ * 𝓞(n³) implementation of the Hungarian algorithm
+ * 
+ * Copyright (C) 2011, 2014, 2020  Mattias Andrée
+ * 
+ * This program is free software. It comes without any warranty, to
+ * the extent permitted by applicable law. You can redistribute it
+ * and/or modify it under the terms of the Do What The Fuck You Want
+ * To Public License, Version 2, as published by Sam Hocevar. See
+ * http://sam.zoy.org/wtfpl/COPYING for more details.
+ */
+
+
+#ifndef HUNGARIAN_H
+#define HUNGARIAN_H
+
+
+#include <sys/types.h>
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+
+/**
+ *  Value type for cells
+ */
+typedef signed long int Cell;
+
+/**
+ * The largest value a cell can hold
+ */
+#define CELL_MAX LONG_MAX
+
+typedef int_fast8_t Boolean;
+
+
+/**
+ * Row and column index, 32 bits unless the library is
+ * compiled with -DHUNGARIAN_INDEX64, tables must be
+ * less than `KUHN_INDEX_MAX` high and wide
+ */
+#if defined(HUNGARIAN_INDEX64)
+typedef uint64_t KuhnIndex;
+# define KUHN_INDEX_MAX UINT64_MAX
+#else
+typedef uint32_t KuhnIndex;
+# define KUHN_INDEX_MAX UINT32_MAX
+#endif
+
+
+typedef struct {
+	KuhnIndex row;
+	KuhnIndex col;
+} CellPosition;
+
+
+/**
+ * The phases of `kuhn_solve`
+ */
+typedef enum {
+	KUHN_PHASE_REDUCE,           /* Row reduction */
+	KUHN_PHASE_MARK,             /* Initial marking of zeroes */
+	KUHN_PHASE_IS_DONE,          /* Check for a complete marking */
+	KUHN_PHASE_FIND_PRIME,       /* Search for an uncovered zero */
+	KUHN_PHASE_ADD_AND_SUBTRACT, /* Update of the table by the uncovered minimum */
+	KUHN_PHASE_ALT_MARKS,        /* Augmentation along an alternating path */
+	KUHN_PHASE_ASSIGN,           /* Extraction of the assignment and potentials */
+	KUHN_PHASE_COUNT
+} KuhnPhase;
+
+
+/**
+ * Function called when a phase of `kuhn_solve` begins
+ * and when it ends, for example to read hardware counters
+ *
+ * @param  data   `KuhnOptions.phase_hook_data`
+ * @param  phase  The phase
+ * @param  begin  1 when the phase begins, 0 when it ends
+ */
+typedef void KuhnPhaseHook(void *data, KuhnPhase phase, Boolean begin);
+
+
+/**
+ * Performance counters for `kuhn_solve`, only counted if
+ * the library is compiled with `-DHUNGARIAN_STATS`, they
+ * are left at zero otherwise; `kuhn_solve_rows`,
+ * `kuhn_solve_oracle`, and `kuhn_solve_cells` always
+ * count `augmentations`, `rows_fetched`, `row_passes`,
+ * and `cells_evaluated`, which cost nothing next to
+ * fetching a row, and `kuhn_solve` always counts
+ * `tiles_updated` and `tiles_scanned`
+ */
+typedef struct {
+	/**
+	 * The number of augmentations
+	 */
+	uint_fast64_t augmentations;
+
+	/**
+	 * The total number of cells on the augmenting alternating paths
+	 */
+	uint_fast64_t path_cells;
+
+	/**
+	 * The number of calls to `kuhn_find_prime`
+	 */
+	uint_fast64_t find_prime_calls;
+
+	/**
+	 * The number of calls to `kuhn_add_and_subtract`
+	 */
+	uint_fast64_t add_and_subtract_rounds;
+
+	/**
+	 * The number of bits set in the bit set of uncovered zeroes
+	 */
+	uint_fast64_t bitset_sets;
+
+	/**
+	 * The number of bits unset in the bit set of uncovered zeroes
+	 */
+	uint_fast64_t bitset_unsets;
+
+	/**
+	 * The number of cells read or written in
+	 * the table or in the marking matrix
+	 */
+	uint_fast64_t cells_scanned;
+
+	/**
+	 * The number of tiles, bands of rows of about `HUNGARIAN_TILE`
+	 * bytes, that `kuhn_add_and_subtract` has updated; each round
+	 * updates the whole table once
+	 */
+	uint_fast64_t tiles_updated;
+
+	/**
+	 * The number of tiles that `kuhn_add_and_subtract` has had to
+	 * scan for their least uncovered cell, in addition to updating
+	 * them; at most `tiles_updated`, which it would be if the minimum
+	 * were always found in a pass of its own over the whole table
+	 */
+	uint_fast64_t tiles_scanned;
+
+	/**
+	 * The number of rows fetched by `kuhn_solve_rows` or
+	 * `kuhn_solve_oracle`, or visited by `kuhn_solve_cells`
+	 */
+	uint_fast64_t rows_fetched;
+
+	/**
+	 * The number of passes over the rows by `kuhn_solve_rows`,
+	 * each of which fetches rows in increasing order
+	 */
+	uint_fast64_t row_passes;
+
+	/**
+	 * The number of cells calculated by `kuhn_solve_cells`
+	 */
+	uint_fast64_t cells_evaluated;
+
+	/**
+	 * The time, in nanoseconds, spent in each phase
+	 */
+	uint_fast64_t phase_ns[KUHN_PHASE_COUNT];
+} KuhnStats;
+
+
+/**
+ * Trace-event file to which solver phases are written as spans,
+ * for use with trace viewers such as Perfetto or chrome://tracing
+ */
+typedef struct kuhn_trace KuhnTrace;
+
+
+/**
+ * Cache of rows for `kuhn_solve_oracle`, see `kuhn_row_cache_create`
+ */
+typedef struct kuhn_row_cache KuhnRowCache;
+
+
+/**
+ * Memory allocator, for example for allocating from a pool or
+ * a NUMA-local arena, `NULL` in `KuhnOptions` for malloc(3)
+ */
+typedef struct {
+	/**
+	 * Allocates memory
+	 *
+	 * @param   data       `data`
+	 * @param   size       The number of bytes to allocate, never 0
+	 * @param   alignment  The required alignment, a power of two
+	 * @return             The memory, `NULL` on failure
+	 */
+	void *(*allocate)(void *data, size_t size, size_t alignment);
+
+	/**
+	 * Deallocates memory
+	 *
+	 * @param  data       `data`
+	 * @param  ptr        The memory
+	 * @param  size       The size the memory was allocated with
+	 * @param  alignment  The alignment the memory was allocated with
+	 */
+	void (*deallocate)(void *data, void *ptr, size_t size, size_t alignment);
+
+	/**
+	 * First argument for `allocate` and `deallocate`
+	 */
+	void *data;
+} KuhnAllocator;
+
+
+/**
+ * Solver options, zero-initialise for the defaults
+ */
+typedef struct {
+	/**
+	 * The number of threads to use in parallel phases,
+	 * 0 or 1 to only use the calling thread
+	 */
+	size_t threads;
+
+	/**
+	 * If not `NULL`, the time, on the `CLOCK_MONOTONIC`
+	 * clock, at which `kuhn_solve` shall stop searching
+	 * for an optimal assignment and instead complete the
+	 * assignment it has so far greedily; it is checked
+	 * after the row reduction, which is always completed,
+	 * during the initial passes over the table, and in
+	 * every step of the search
+	 */
+	const struct timespec *deadline;
+
+	/**
+	 * If non-zero, `kuhn_solve` finds an assignment with
+	 * maximum, rather than minimum, total cost
+	 */
+	Boolean maximize;
+
+	/**
+	 * If not `NULL`, `kuhn_solve` stores its performance counters here
+	 */
+	KuhnStats *stats;
+
+	/**
+	 * If not `NULL`, each phase of `kuhn_solve`, and each
+	 * worker in the parallel phases of `kuhn_kbest`, is
+	 * written to this trace as a span
+	 */
+	KuhnTrace *trace;
+
+	/**
+	 * If not `NULL`, called when each phase of `kuhn_solve`
+	 * begins and ends, outside the time measured for
+	 * `stats` and `trace`
+	 */
+	KuhnPhaseHook *phase_hook;
+
+	/**
+	 * First argument for `phase_hook`
+	 */
+	void *phase_hook_data;
+
+	/**
+	 * If not `NULL`, all memory `kuhn_solve` allocates, including
+	 * the arrays in the result, is allocated with this allocator,
+	 * which must remain valid until the result is destroyed
+	 */
+	const KuhnAllocator *allocator;
+} KuhnOptions;
+
+
+/**
+ * The result of `kuhn_solve`
+ */
+typedef struct {
+	/**
+	 * The assignment, the column assigned to each row
+	 */
+	KuhnIndex *col_of_row;
+
+	/**
+	 * The potential of each row
+	 */
+	Cell *row_potential;
+
+	/**
+	 * The potential of each column, these are never positive,
+	 * (never negative when maximising) and are zero for the
+	 * columns that are not assigned
+	 */
+	Cell *col_potential;
+
+	/**
+	 * The total cost of the assignment
+	 */
+	Cell cost;
+
+	/**
+	 * The sum of all potentials, a lower bound for the
+	 * cost of any assignment (an upper bound when
+	 * maximising), equal to `cost` if the assignment
+	 * is optimal
+	 */
+	Cell lower_bound;
+
+	/**
+	 * Whether the assignment is optimal, 0 if the deadline
+	 * was reached and the assignment was completed greedily
+	 */
+	Boolean optimal;
+
+	/**
+	 * The allocator of the arrays, and the size of the
+	 * table, for `kuhn_result_destroy`
+	 */
+	const KuhnAllocator *allocator;
+	size_t height, width;
+} KuhnResult;
+
+
+/**
+ * An upper bound of `kuhn_workspace_size(n, m)` that is a
+ * constant expression if `n` and `m` are, for static storage
+ */
+#define KUHN_WORKSPACE_BOUND(n, m)\
+	((size_t)(n) * (size_t)(m) * 2 +\
+	 (size_t)(n) * (4 * sizeof(Cell) + 3 * sizeof(CellPosition) + sizeof(ssize_t) + sizeof(void *) + 2) +\
+	 (size_t)(m) * (sizeof(Cell) + sizeof(ssize_t) + sizeof(uint64_t) + 2) + 1280)
+
+/*
+ * The library may be built with -DHUNGARIAN_MAX_N=n and -DHUNGARIAN_MAX_M=m,
+ * for systems where memory must not be allocated after initialisation. Then,
+ * if no allocator is given, `kuhn_solve` and `kuhn_match` solve in a static
+ * workspace of `KUHN_WORKSPACE_MAX` bytes, rather than allocating, and fail
+ * with `ENOMEM` for larger tables. The result is then only valid until the
+ * next such call, and neither function is reentrant. The assignment from
+ * `kuhn_match` must not be freed.
+ */
+#if defined(HUNGARIAN_MAX_N) && defined(HUNGARIAN_MAX_M)
+# define KUHN_WORKSPACE_MAX  KUHN_WORKSPACE_BOUND(HUNGARIAN_MAX_N, HUNGARIAN_MAX_M)
+#endif
+
+
+/**
+ * Stateful assignment solver that keeps an optimal matching,
+ * and its dual potentials, while rows and columns are added
+ * and removed
+ */
+typedef struct kuhn_solver KuhnSolver;
+
+
+
+/**
+ * Calculates an optimal bipartite minimum weight matching using an
+ * O(n³)-time implementation of The Hungarian Algorithm, also known
+ * as Kuhn's Algorithm.
+ *
+ * The table must not be higher than it is wide, and its
+ * content will be destroyed
+ *
+ * @param   n      The height of the table
+ * @param   m      The width of the table
+ * @param   table  The table in which to perform the matching
+ * @return         The optimal assignment, an array of row–coloumn pairs,
+ *                 `NULL` on error; `EINVAL` if `n` is greater than `m`
+ */
+CellPosition *kuhn_match(size_t n, size_t m, Cell **table);
+
+/**
+ * Like `kuhn_match`, but also outputs the dual potentials that
+ * certify that the assignment is optimal, see `kuhn_verify`
+ *
+ * For every cell, the sum of its row's potential and its column's
+ * potential is at most the cell's cost, with equality for the
+ * assigned cells
+ *
+ * If `options->maximize` is set, the table is reduced for a
+ * maximum matching in place, without a negated copy, and the
+ * inequalities on the potentials are reversed
+ *
+ * If `options->deadline` is reached, the assignment found so far is
+ * completed greedily, and the potentials and `result->lower_bound`
+ * still bound the cost of the optimal assignment
+ *
+ * @param   n        The height of the table, must not be greater than `m`
+ * @param   m        The width of the table
+ * @param   table    The table in which to perform the matching,
+ *                   its content will be destroyed
+ * @param   options  Solver options, may be `NULL`
+ * @param   result   Output parameter for the result, release
+ *                   with `kuhn_result_destroy`
+ * @return           0 on success, -1 on error; `EINVAL`
+ *                   if `n` is greater than `m`
+ */
+int kuhn_solve(size_t n, size_t m, Cell **table, const KuhnOptions *options, KuhnResult *result);
+
+/**
+ * Function that fetches the costs of a row, for `kuhn_solve_rows`
+ *
+ * @param   data  `data` as passed to `kuhn_solve_rows`
+ * @param   row   The index of the row
+ * @param   buf   Buffer with room for one row, that
+ *                the function may but need not fill
+ * @return        The row's costs, indexed by column, valid until
+ *                the next call, `NULL` on error, with `errno` set
+ */
+typedef const Cell *KuhnRowFunction(void *data, size_t row, Cell *buf);
+
+/**
+ * Like `kuhn_solve`, but for tables too large to be kept in memory,
+ * such as a file mapping larger than the RAM, which are fetched a
+ * row at a time, and the solver only keeps 𝓞(n + m) memory
+ *
+ * The rows are fetched in passes, in each of which they are
+ * fetched in increasing order, so that the table is read
+ * sequentially. First every row is fetched once, then each
+ * row that is not yet assigned is assigned along a shortest
+ * augmenting path, whose distances are found with as many
+ * passes as it takes for them to stop improving; only rows
+ * that are reached, and closer than the nearest free column
+ * found so far, are fetched in those passes
+ *
+ * `options->stats`, if set, counts the rows fetched and the
+ * passes, also without `-DHUNGARIAN_STATS`, and each augmentation
+ * fires the USDT probe "rows_augment" with the number of rows
+ * fetched and the number of passes it took
+ *
+ * If `options->deadline` is reached, every row that is not yet
+ * assigned is assigned to its cheapest free column, in one last
+ * pass. `options->maximize` and `options->allocator` are used as
+ * by `kuhn_solve`
+ *
+ * @param   n        The height of the table, must not be greater than `m`
+ * @param   m        The width of the table
+ * @param   get_row  Function that fetches a row of the table
+ * @param   data     First argument for `get_row`
+ * @param   options  Solver options, may be `NULL`
+ * @param   result   Output parameter for the result, release
+ *                   with `kuhn_result_destroy`
+ * @return           0 on success, -1 on error, including
+ *                   when `get_row` fails
+ */
+int kuhn_solve_rows(size_t n, size_t m, KuhnRowFunction *get_row, void *data,
+                    const KuhnOptions *options, KuhnResult *result);
+
+/**
+ * Like `kuhn_solve_rows`, but for rows that are calculated rather
+ * than read, such as from feature vectors, and thus can be fetched
+ * in any order, so that the rows are visited in the order of their
+ * distance, each at most once per augmentation; the table is never
+ * stored, and the solver only keeps 𝓞(n + m) memory
+ *
+ * As rows are visited again in later augmentations, an expensive
+ * `get_row` can be put behind a `KuhnRowCache`
+ *
+ * @param   n        The height of the table, must not be greater than `m`
+ * @param   m        The width of the table
+ * @param   get_row  Function that calculates a row of the table
+ * @param   data     First argument for `get_row`
+ * @param   options  Solver options, may be `NULL`
+ * @param   result   Output parameter for the result, release
+ *                   with `kuhn_result_destroy`
+ * @return           0 on success, -1 on error, including
+ *                   when `get_row` fails
+ */
+int kuhn_solve_oracle(size_t n, size_t m, KuhnRowFunction *get_row, void *data,
+                      const KuhnOptions *options, KuhnResult *result);
+
+/**
+ * Function that calculates the cost of a cell, for `kuhn_solve_cells`
+ *
+ * @param   data  `data` as passed to `kuhn_solve_cells`
+ * @param   row   The index of the cell's row
+ * @param   col   The index of the cell's column
+ * @return        The cell's cost
+ */
+typedef Cell KuhnCellFunction(void *data, size_t row, size_t col);
+
+/**
+ * Like `kuhn_solve_oracle`, but calculates the costs a cell at a time
+ *
+ * Every cell is calculated once to begin with, but afterwards
+ * only the cells that can shorten the distance to their column
+ * are; `options->stats`, if set, counts them in `cells_evaluated`
+ *
+ * @param   n         The height of the table, must not be greater than `m`
+ * @param   m         The width of the table
+ * @param   get_cell  Function that calculates a cell of the table
+ * @param   data      First argument for `get_cell`
+ * @param   options   Solver options, may be `NULL`
+ * @param   result    Output parameter for the result, release
+ *                    with `kuhn_result_destroy`
+ * @return            0 on success, -1 on error
+ */
+int kuhn_solve_cells(size_t n, size_t m, KuhnCellFunction *get_cell, void *data,
+                     const KuhnOptions *options, KuhnResult *result);
+
+/**
+ * Creates a cache of the most recently fetched rows of a table,
+ * to put in front of an expensive `KuhnRowFunction` when rows are
+ * fetched repeatedly, as rows near the augmenting paths are by
+ * `kuhn_solve_oracle`; rows are evicted least recently used first
+ *
+ * Use `kuhn_row_cache_fetch` as the `KuhnRowFunction`, and
+ * the cache as its `data`
+ *
+ * @param   n          The height of the table
+ * @param   m          The width of the table
+ * @param   capacity   The number of rows to keep, at least 1
+ * @param   get_row    Function that fetches a row of the table
+ * @param   data       First argument for `get_row`
+ * @param   allocator  Allocator for the cache, `NULL` for malloc(3)
+ * @return             The cache, `NULL` on error
+ */
+KuhnRowCache *kuhn_row_cache_create(size_t n, size_t m, size_t capacity, KuhnRowFunction *get_row,
+                                    void *data, const KuhnAllocator *allocator);
+
+/**
+ * Fetches a row through a cache, a `KuhnRowFunction`
+ *
+ * @param   cache  The cache
+ * @param   row    The index of the row
+ * @param   buf    Unused, the row is kept in the cache
+ * @return         The row's costs, valid until the next
+ *                 call, `NULL` if the row could not be fetched
+ */
+const Cell *kuhn_row_cache_fetch(void *cache, size_t row, Cell *buf);
+
+/**
+ * Gets the number of rows a cache has had and has not had
+ *
+ * @param  cache    The cache
+ * @param  hitsp    Output parameter for the number of rows found in the cache
+ * @param  missesp  Output parameter for the number of rows fetched into it
+ */
+void kuhn_row_cache_stats(const KuhnRowCache *cache, uint_fast64_t *hitsp, uint_fast64_t *missesp);
+
+/**
+ * Deallocates a row cache
+ *
+ * @param  cache  The cache, may be `NULL`
+ */
+void kuhn_row_cache_destroy(KuhnRowCache *cache);
+
+/**
+ * Deallocates the arrays in a result from `kuhn_solve`
+ *
+ * @param  result  The result
+ */
+void kuhn_result_destroy(KuhnResult *result);
+
+/**
+ * Calculates the size of the memory `kuhn_solve_in` needs
+ *
+ * @param   n  The height of the table
+ * @param   m  The width of the table
+ * @return     The number of bytes, 0 if the size does not fit in `size_t`
+ */
+size_t kuhn_workspace_size(size_t n, size_t m);
+
+/**
+ * Like `kuhn_solve`, but without allocating memory, all memory,
+ * including the arrays in the result, is taken from `workspace`
+ *
+ * `kuhn_solve_in` has a small, constant stack usage: it does not
+ * recurse and it has no variable-length arrays, the deepest call
+ * chain uses less than 1 KiB on x86-64 (more with a `phase_hook`
+ * or a `trace`, which may allocate when it is first written)
+ *
+ * The result remains valid until the workspace is reused, it
+ * need not, but may, be destroyed with `kuhn_result_destroy`
+ *
+ * @param   n          The height of the table
+ * @param   m          The width of the table
+ * @param   table      The table in which to perform the matching,
+ *                     its content will be destroyed
+ * @param   options    Solver options, may be `NULL`,
+ *                     `options->allocator` is ignored
+ * @param   workspace  Memory for the solver, need not be aligned
+ * @param   size       The size of `workspace`, at least
+ *                     `kuhn_workspace_size(n, m)` bytes
+ * @param   result     Output parameter for the result
+ * @return             0 on success, -1 on error
+ *                     (`ENOMEM` if `workspace` is too small)
+ */
+int kuhn_solve_in(size_t n, size_t m, Cell **table, const KuhnOptions *options,
+                  void *workspace, size_t size, KuhnResult *result);
+
+/**
+ * Verifies, in 𝓞(nm) time, that an assignment is optimal, by
+ * checking that the potentials are dual feasible and that
+ * complementary slackness holds
+ *
+ * `kuhn_solve` destroys its table, so the original costs
+ * must be passed in a copy made before the call
+ *
+ * @param   n              The height of the table
+ * @param   m              The width of the table
+ * @param   table          The original costs
+ * @param   col_of_row     The assignment, the column assigned to each row
+ * @param   row_potential  The potential of each row
+ * @param   col_potential  The potential of each column
+ * @return                 1 if the assignment is proven
+ *                         to be optimal, 0 otherwise
+ */
+Boolean kuhn_verify(size_t n, size_t m, Cell *const *table, const KuhnIndex *col_of_row,
+                    const Cell *row_potential, const Cell *col_potential);
+
+/**
+ * Like `kuhn_verify`, but verifies that the assignment
+ * is a maximum, for results from `kuhn_solve` with
+ * `options->maximize` set
+ *
+ * @param   n              The height of the table
+ * @param   m              The width of the table
+ * @param   table          The original costs
+ * @param   col_of_row     The assignment, the column assigned to each row
+ * @param   row_potential  The potential of each row
+ * @param   col_potential  The potential of each column
+ * @return                 1 if the assignment is proven
+ *                         to be optimal, 0 otherwise
+ */
+Boolean kuhn_verify_max(size_t n, size_t m, Cell *const *table, const KuhnIndex *col_of_row,
+                        const Cell *row_potential, const Cell *col_potential);
+
+
+/**
+ * Finds the `k` best assignments, in order of increasing cost,
+ * using Murty's partitioning of the solution space
+ *
+ * Each subproblem is solved from its parent's matching and dual
+ * potentials with a single shortest augmenting path instead of
+ * with a full solve, and the subproblems of a partition are
+ * solved in parallel if `options->threads` is greater than 1;
+ * the threads, at most one per online processor, are started
+ * once and kept until `kuhn_kbest` returns
+ *
+ * With `options->maximize`, the assignments are found in order
+ * of decreasing cost instead. If `options->deadline` passes,
+ * the search stops and returns the assignments found so far,
+ * which are still the best ones, and always at least the first.
+ * `options->allocator` is not supported and must be `NULL`, and
+ * `options->stats` and `options->phase_hook` are not used
+ *
+ * @param   n            The height of the table, must not be greater than `m`
+ * @param   m            The width of the table
+ * @param   table        The table, it is not modified
+ * @param   k            The maximum number of assignments to find
+ * @param   options      Solver options, may be `NULL`
+ * @param   assignments  Output array of `k * n` columns, the column assigned
+ *                       to row `r` in the `i`:th assignment is stored in
+ *                       `assignments[i * n + r]`
+ * @param   costs        Output array for the cost of each assignment
+ * @return               The number of assignments found, which is less
+ *                       than `k` if there are not `k` different
+ *                       assignments or if the deadline passed, -1 on
+ *                       error; `EINVAL` if `n > m` or if an allocator
+ *                       is given
+ */
+ssize_t kuhn_kbest(size_t n, size_t m, Cell *const *table, size_t k, const KuhnOptions *options,
+                   KuhnIndex *assignments, Cell *costs);
+
+
+/**
+ * Creates an empty solver
+ *
+ * The solver grows automatically, `n` and `m` are
+ * only the capacities allocated up front
+ *
+ * @param   n  The number of rows to allocate room for
+ * @param   m  The number of columns to allocate room for
+ * @return     The solver, `NULL` on error
+ */
+KuhnSolver *kuhn_solver_create(size_t n, size_t m);
+
+/**
+ * Deallocates a solver
+ *
+ * @param  solver  The solver, may be `NULL`
+ */
+void kuhn_solver_destroy(KuhnSolver *solver);
+
+/**
+ * Adds a row and updates the matching with one augmentation
+ *
+ * @param   solver  The solver
+ * @param   costs   The row's cost for each column, indexed by column
+ *                  identifier; entries for unused identifiers are ignored
+ * @return          The row's identifier, -1 on error
+ */
+ssize_t kuhn_solver_add_row(KuhnSolver *solver, const Cell costs[]);
+
+/**
+ * Adds a column and updates the matching with one augmentation
+ *
+ * @param   solver  The solver
+ * @param   costs   The column's cost for each row, indexed by row
+ *                  identifier; entries for unused identifiers are ignored
+ * @return          The column's identifier, -1 on error
+ */
+ssize_t kuhn_solver_add_col(KuhnSolver *solver, const Cell costs[]);
+
+/**
+ * Removes a row and updates the matching with at most one augmentation
+ *
+ * The identifier may be reused by a later call to `kuhn_solver_add_row`
+ *
+ * @param   solver  The solver
+ * @param   row     The row's identifier
+ * @return          0 on success, -1 on error
+ */
+int kuhn_solver_remove_row(KuhnSolver *solver, size_t row);
+
+/**
+ * Removes a column and updates the matching with at most one augmentation
+ *
+ * The identifier may be reused by a later call to `kuhn_solver_add_col`
+ *
+ * @param   solver  The solver
+ * @param   col     The column's identifier
+ * @return          0 on success, -1 on error
+ */
+int kuhn_solver_remove_col(KuhnSolver *solver, size_t col);
+
+/**
+ * Gets the column a row is assigned to
+ *
+ * @param   solver  The solver
+ * @param   row     The row's identifier
+ * @return          The column's identifier, -1 if the row is
+ *                  unassigned because there are more rows than columns
+ */
+ssize_t kuhn_solver_col_of(const KuhnSolver *solver, size_t row);
+
+/**
+ * Gets the row a column is assigned to
+ *
+ * @param   solver  The solver
+ * @param   col     The column's identifier
+ * @return          The row's identifier, -1 if the column is
+ *                  unassigned because there are more columns than rows
+ */
+ssize_t kuhn_solver_row_of(const KuhnSolver *solver, size_t col);
+
+/**
+ * Gets the total cost of the current assignment
+ *
+ * @param   solver  The solver
+ * @return          The sum of the costs of all assigned cells
+ */
+Cell kuhn_solver_cost(const KuhnSolver *solver);
+
+
+/**
+ * Creates a trace-event file
+ *
+ * The trace may be used by any number of solves, also
+ * concurrently, but is only a valid JSON file once closed;
+ * each thread's spans are put on a track of its own
+ *
+ * @param   path  The file to write
+ * @return        The trace, `NULL` on error
+ */
+KuhnTrace *kuhn_trace_open(const char *path);
+
+/**
+ * Finishes and closes a trace-event file
+ *
+ * @param   trace  The trace, may be `NULL`
+ * @return         0 on success, -1 if the trace could not be written
+ */
+int kuhn_trace_close(KuhnTrace *trace);
+
+
+/**
+ * Flag for `kuhn_page_allocator`: back the memory with huge pages,
+ * reserved ones if there are any, otherwise transparent ones
+ */
+#define KUHN_PAGES_HUGE  1
+
+/**
+ * Flag for `kuhn_page_allocator`: spread the pages round-robin over
+ * the NUMA nodes, rather than placing each page on the node of the
+ * thread that first touches it
+ */
+#define KUHN_PAGES_INTERLEAVE  2
+
+/**
+ * Gets an allocator that maps memory directly, for large tables and
+ * for `KuhnOptions.allocator`, so that the memory can be placed with
+ * huge pages and across NUMA nodes
+ *
+ * Each allocation is a mapping of its own, rounded up to whole pages.
+ * Huge pages and interleaving are only available on Linux, and are
+ * silently left out where the system does not support them
+ *
+ * @param   flags  `KUHN_PAGES_HUGE` and `KUHN_PAGES_INTERLEAVE`, combined
+ *                 with bitwise or, or 0 for the system's default placement
+ * @return         The allocator, valid for the lifetime of the program
+ */
+const KuhnAllocator *kuhn_page_allocator(int flags);
+
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
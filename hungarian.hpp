@@ -0,0 +1,126 @@
+/**
+ * 𝓞(n³) implementation of the Hungarian algorithm
+ * 
+ * Copyright (C) 2011, 2014, 2020  Mattias Andrée
+ * 
+ * This program is free software. It comes without any warranty, to
+ * the extent permitted by applicable law. You can redistribute it
+ * and/or modify it under the terms of the Do What The Fuck You Want
+ * To Public License, Version 2, as published by Sam Hocevar. See
+ * http://sam.zoy.org/wtfpl/COPYING for more details.
+ */
+
+
+#ifndef HUNGARIAN_HPP
+#define HUNGARIAN_HPP
+
+
+#include "hungarian.h"
+
+#include <cerrno>
+#include <cstddef>
+#include <memory_resource>
+#include <system_error>
+
+
+namespace hungarian {
+
+
+/**
+ * Adapts a `std::pmr::memory_resource` to `KuhnAllocator`
+ *
+ * Results keep a pointer to the allocator, so it must outlive
+ * them and it cannot be copied or moved
+ */
+class PmrAllocator {
+public:
+	explicit PmrAllocator(std::pmr::memory_resource *resource = std::pmr::get_default_resource()) noexcept
+		: vtable_{allocate_, deallocate_, resource} {}
+
+	PmrAllocator(const PmrAllocator &) = delete;
+	PmrAllocator &operator=(const PmrAllocator &) = delete;
+
+	/**
+	 * @return  The allocator, for `KuhnOptions.allocator`
+	 */
+	const KuhnAllocator *get() const noexcept { return &vtable_; }
+
+private:
+	/* Exceptions must not unwind through the library, which is C,
+	 * so a failed allocation is reported to it as `NULL` */
+	static void *allocate_(void *data, std::size_t size, std::size_t alignment) noexcept
+	{
+		try {
+			return static_cast<std::pmr::memory_resource *>(data)->allocate(size, alignment);
+		} catch (...) {
+			return nullptr;
+		}
+	}
+
+	static void deallocate_(void *data, void *ptr, std::size_t size, std::size_t alignment) noexcept
+	{
+		static_cast<std::pmr::memory_resource *>(data)->deallocate(ptr, size, alignment);
+	}
+
+	KuhnAllocator vtable_;
+};
+
+
+/**
+ * A result from `kuhn_solve` that destroys itself
+ */
+class Result {
+public:
+	Result() noexcept : result_{} {}
+	Result(Result &&other) noexcept : result_(other.result_) { other.result_ = KuhnResult{}; }
+	Result(const Result &) = delete;
+	Result &operator=(const Result &) = delete;
+	~Result() { kuhn_result_destroy(&result_); }
+
+	Result &operator=(Result &&other) noexcept
+	{
+		if (this != &other) {
+			kuhn_result_destroy(&result_);
+			result_ = other.result_;
+			other.result_ = KuhnResult{};
+		}
+		return *this;
+	}
+
+	const KuhnResult &operator*() const noexcept { return result_; }
+	const KuhnResult *operator->() const noexcept { return &result_; }
+
+private:
+	friend Result solve(std::size_t, std::size_t, Cell **, const PmrAllocator &, KuhnOptions);
+
+	KuhnResult result_;
+};
+
+
+/**
+ * Calls `kuhn_solve` with all memory allocated from a memory resource
+ *
+ * @param   n          The height of the table
+ * @param   m          The width of the table
+ * @param   table      The table, its content will be destroyed
+ * @param   allocator  The memory resource, it must outlive the result
+ * @param   options    Solver options, `options.allocator` is ignored
+ * @return             The result
+ * @throws             std::system_error if `kuhn_solve` fails
+ */
+inline Result
+solve(std::size_t n, std::size_t m, Cell **table, const PmrAllocator &allocator, KuhnOptions options = {})
+{
+	Result result;
+
+	options.allocator = allocator.get();
+	if (kuhn_solve(n, m, table, &options, &result.result_))
+		throw std::system_error(errno, std::generic_category(), "kuhn_solve");
+	return result;
+}
+
+
+}
+
+
+#endif
@@ -0,0 +1,1422 @@
+/**
+ * 𝓞(n³) implementation of the Hungarian algorithm
+ * 
+ * Copyright (C) 2011, 2014, 2020  Mattias Andrée
+ * 
+ * This program is free software. It comes without any warranty, to
+ * the extent permitted by applicable law. You can redistribute it
+ * and/or modify it under the terms of the Do What The Fuck You Want
+ * To Public License, Version 2, as published by Sam Hocevar. See
+ * http://sam.zoy.org/wtfpl/COPYING for more details.
+ */
+
+
+#include "common.h"
+#include "probes.h"
+
+
+/*
+ * Phase timing is only compiled in with -DHUNGARIAN_STATS, tracing
+ * and phase hooks only cost a few checks per phase
+ */
+#if defined(HUNGARIAN_STATS)
+# define TIMING(stats)  (stats)
+#else
+# define TIMING(stats)  0
+#endif
+
+#define TIMED(options, phase, statement)\
+	do {\
+		uint_fast64_t start__ = (options) ? kuhn_phase_begin(options, phase) : 0;\
+		statement;\
+		if (options)\
+			kuhn_phase_end(options, phase, start__);\
+	} while (0)
+
+
+/**
+ * Cell markings
+ **/
+enum {
+	UNMARKED = 0,
+	MARKED,
+	PRIME
+};
+
+
+/**
+ * Index stored for rows without a prime and columns without a mark
+ */
+#define NO_INDEX  ((KuhnIndex)-1)
+
+
+/**
+ *  Value type for marking
+ */
+typedef int_fast8_t Mark;
+
+/**
+ * A limb of a bit set, 64 bits
+ */
+typedef uint64_t BitSetLimb;
+
+
+/**
+ * Bit set, a set of fixed number of bits/booleans
+ */
+typedef struct {
+	/**
+	 * The set of all limbs, a limb consist of 64 bits
+	 */
+	BitSetLimb *limbs;
+
+	/**
+	 * Singleton array with the index of the first non-zero limb
+	 */
+	size_t first;
+
+	/**
+	 * Array the the index of the previous non-zero limb for each limb
+	 */
+	size_t *prev;
+
+	/**
+	 * Array the the index of the next non-zero limb for each limb
+	 */
+	size_t *next;
+} BitSet;
+
+
+/**
+ * The smallest height for which `kuhn_solve` keeps a column-major
+ * index of the zeroes in the table; in smaller tables, the rows
+ * touched when scanning a column are likely to be in the cache
+ */
+#if !defined(HUNGARIAN_TRANSPOSE_MIN)
+# define HUNGARIAN_TRANSPOSE_MIN  128
+#endif
+
+/**
+ * The number of bytes of the table in a tile, a band of whole
+ * rows that `kuhn_add_and_subtract` finishes before it moves on
+ * to the next; about the size of an L2 cache, so that a tile
+ * that has to be scanned again is still in the cache
+ */
+#if !defined(HUNGARIAN_TILE)
+# define HUNGARIAN_TILE  (1 << 20)
+#endif
+
+/**
+ * The number of rows in a tile, at least one
+ */
+#define TILE_ROWS(m)  ((m) && HUNGARIAN_TILE / ((m) * sizeof(Cell)) ? HUNGARIAN_TILE / ((m) * sizeof(Cell)) : 1)
+
+/**
+ * The number of tiles in a table
+ */
+#define TILE_COUNT(n, m)  (((n) + TILE_ROWS(m) - 1) / TILE_ROWS(m))
+
+
+/**
+ * The size of a cache line, which the working memory is aligned to
+ */
+#define CACHE_LINE  64
+
+/**
+ * Rounds a size up to a whole number of cache lines
+ */
+#define ROUND_LINE(size)  (((size) + (CACHE_LINE - 1)) & ~(size_t)(CACHE_LINE - 1))
+
+
+/**
+ * The working memory of `kuhn_solve`, all of it is carved from a single
+ * block, each array starting on its own cache line, and with the arrays
+ * used in every phase placed first
+ */
+typedef struct {
+	/**
+	 * The block, the only allocation
+	 */
+	void *block;
+
+	/**
+	 * The size of `block`
+	 */
+	size_t size;
+
+	/**
+	 * Row cover set
+	 */
+	Cover *row_covered;
+
+	/**
+	 * Column cover set
+	 */
+	Cover *col_covered;
+
+	/**
+	 * Primes in the rows, for `kuhn_alt_marks`
+	 */
+	KuhnIndex *row_primes;
+
+	/**
+	 * Markings in the columns, for `kuhn_alt_marks`
+	 */
+	KuhnIndex *col_marks;
+
+	/**
+	 * Marking modification path, for `kuhn_alt_marks`, the path
+	 * alternates between primes and marks, of which there are at
+	 * most n, so it has at most 2n + 1 cells
+	 */
+	CellPosition *alt;
+
+	/**
+	 * Uncovered zeroes, for `kuhn_find_prime`, filled
+	 * by `kuhn_add_and_subtract`, and otherwise empty
+	 */
+	BitSet zeroes;
+
+	/**
+	 * The marking matrix
+	 */
+	Mark **marks;
+
+	/**
+	 * The zeroes in the table, column by column, `COVER_LIMBS(n)`
+	 * limbs per column with one bit per row, so that a column can
+	 * be scanned for zeroes without reading a cell in every row;
+	 * `NULL` if the table has fewer than `HUNGARIAN_TRANSPOSE_MIN` rows
+	 */
+	Cover *col_zeroes;
+
+	/**
+	 * The least uncovered cell in each tile, as it was left by
+	 * the last `kuhn_add_and_subtract`, under `seen_row_covered`
+	 * and `seen_col_covered`
+	 */
+	Cell *tile_min;
+
+	/**
+	 * The tiles for which `tile_min` is not up to date
+	 */
+	Cover *tile_dirty;
+
+	/**
+	 * The row cover set as it was after the last `kuhn_add_and_subtract`
+	 */
+	Cover *seen_row_covered;
+
+	/**
+	 * The column cover set as it was after the last `kuhn_add_and_subtract`
+	 */
+	Cover *seen_col_covered;
+} KuhnWork;
+
+
+
+/**
+ * The names of the phases in traces
+ */
+static const char *const phase_names[] = {
+	[KUHN_PHASE_REDUCE]           = "kuhn_reduce_rows",
+	[KUHN_PHASE_MARK]             = "kuhn_mark",
+	[KUHN_PHASE_IS_DONE]          = "kuhn_is_done",
+	[KUHN_PHASE_FIND_PRIME]       = "kuhn_find_prime",
+	[KUHN_PHASE_ADD_AND_SUBTRACT] = "kuhn_add_and_subtract",
+	[KUHN_PHASE_ALT_MARKS]        = "kuhn_alt_marks",
+	[KUHN_PHASE_ASSIGN]           = "kuhn_assign"
+};
+
+
+/**
+ * Records the beginning of a phase
+ *
+ * @param   options  Solver options
+ * @param   phase    The phase
+ * @return           The current time if the phase is timed, otherwise 0
+ */
+static uint_fast64_t
+kuhn_phase_begin(const KuhnOptions *options, KuhnPhase phase)
+{
+	if (options->phase_hook)
+		options->phase_hook(options->phase_hook_data, phase, 1);
+	return (TIMING(options->stats) || options->trace) ? kuhn_now() : 0;
+}
+
+
+/**
+ * Records the end of a phase
+ *
+ * @param  options  Solver options
+ * @param  phase    The phase
+ * @param  start    The return value of `kuhn_phase_begin`
+ */
+static void
+kuhn_phase_end(const KuhnOptions *options, KuhnPhase phase, uint_fast64_t start)
+{
+	uint_fast64_t end;
+
+	if (TIMING(options->stats) || options->trace) {
+		end = kuhn_now();
+#if defined(HUNGARIAN_STATS)
+		if (options->stats)
+			options->stats->phase_ns[phase] += end - start;
+#endif
+		if (options->trace)
+			trace_span(options->trace, phase_names[phase], start, end);
+	}
+
+	if (options->phase_hook)
+		options->phase_hook(options->phase_hook_data, phase, 0);
+}
+
+
+/**
+ * Turns off all bits in a bit set
+ *
+ * Only the non-zero limbs are visited,
+ * so this is cheap for a sparse bit set
+ *
+ * @param  this  The bit set
+ */
+static void
+bitset_clear(BitSet *this)
+{
+	size_t j;
+
+	for (j = this->first; j; j = this->next[j])
+		this->limbs[j - 1] = 0;
+	this->first = 0;
+}
+
+
+/**
+ * Gets the index of any set bit in a bit set
+ * 
+ * @param   this  The bit set
+ * @return        The index of any set bit
+ */
+#if defined(__GNUC__)
+__attribute__((__pure__))
+#endif
+static ssize_t
+bitset_any(BitSet *this)
+{
+	size_t i;
+
+	if (!this->first)
+		return -1;
+
+	i = this->first - 1;
+	return (ssize_t)(LOWEST_BIT(this->limbs[i]) + (i << 6));
+}
+
+
+/**
+ * Turns off a bit in a bit set
+ * 
+ * @param  this  The bit set
+ * @param  i     The index of the bit to turn off
+ */
+static void
+bitset_unset(BitSet *this, size_t i)
+{
+	size_t p, n, j = i >> 6;
+	BitSetLimb old = this->limbs[j];
+
+	this->limbs[j] &= ~((BitSetLimb)1 << (i & 63L));
+
+	if (!this->limbs[j] ^ !old) {
+		j++;
+		p = this->prev[j];
+		n = this->next[j];
+		this->prev[n] = p;
+		this->next[p] = n;
+		if (this->first == j)
+			this->first = n;
+	}
+}
+
+
+/**
+ * Turns on a bit in a bit set
+ * 
+ * @param  this  The bit set
+ * @param  i     The index of the bit to turn on
+ */
+static void
+bitset_set(BitSet *this, size_t i)
+{
+	size_t j = i >> 6;
+	BitSetLimb old = this->limbs[j];
+
+	this->limbs[j] |= (BitSetLimb)1 << (i & 63L);
+
+	if (!this->limbs[j] ^ !old) {
+		j++;
+		this->prev[this->first] = j;
+		this->prev[j] = 0;
+		this->next[j] = this->first;
+		this->first = j;
+	}
+}
+
+
+/**
+ * Reduces the values on each rows so that, for each row, the
+ * lowest cells value is zero, and all cells' values is decrease
+ * with the same value [the minium value in the row].
+ *
+ * When maximising, each cell is instead replaced by how much
+ * lower it is than the highest value in the row, which is
+ * the same as reducing the negated table, but without
+ * making a negated copy of it
+ * 
+ * @param  n         The table's height
+ * @param  m         The table's width
+ * @param  t         The table in which to perform the reduction
+ * @param  u         Output array for the row potentials, the
+ *                   value subtracted from each row
+ * @param  maximize  Whether to reduce for a maximum matching
+ * @param  stats     Performance counters, may be `NULL`
+ */
+static void
+kuhn_reduce_rows(size_t n, size_t m, Cell **t, Cell u[n], Boolean maximize, KuhnStats *stats)
+{
+	size_t i, j;
+	Cell min, max, *ti;
+
+	for (i = 0; i < n; i++) {
+		ti = t[i];
+		if (maximize) {
+			max = *ti;
+			for (j = 1; j < m; j++)
+				if (max < ti[j])
+					max = ti[j];
+			for (j = 0; j < m; j++)
+				ti[j] = max - ti[j];
+			u[i] = -max;
+		} else {
+			min = *ti;
+			for (j = 1; j < m; j++)
+				if (min > ti[j])
+					min = ti[j];
+			for (j = 0; j < m; j++)
+				ti[j] -= min;
+			u[i] = min;
+		}
+	}
+
+	STAT(stats, cells_scanned, 2 * n * m);
+}
+
+
+/**
+ * Builds the column-major index of the zeroes in a table
+ *
+ * The deadline is checked after each tile of rows
+ *
+ * @param   n           The table's height
+ * @param   m           The table's width
+ * @param   t           The table
+ * @param   col_zeroes  Output matrix, `COVER_LIMBS(n)` limbs
+ *                      per column, must be cleared
+ * @param   deadline    The deadline, may be `NULL`
+ * @param   stats       Performance counters, may be `NULL`
+ * @return              Whether the index was completed, 0 if
+ *                      the deadline was reached first
+ */
+static Boolean
+kuhn_index_zeroes(size_t n, size_t m, Cell **t, Cover *col_zeroes,
+                  const struct timespec *deadline, KuhnStats *stats)
+{
+	size_t i, j, limbs = COVER_LIMBS(n), rows = TILE_ROWS(m);
+	const Cell *ti;
+
+	for (i = 0; i < n; i++) {
+		if (i % rows == 0 && i && kuhn_expired(deadline))
+			break;
+		ti = t[i];
+		for (j = 0; j < m; j++)
+			if (!ti[j])
+				COVER(&col_zeroes[j * limbs], i);
+	}
+
+	STAT(stats, cells_scanned, i * m);
+	return i == n;
+}
+
+
+/**
+ * Determines whether the marking is complete, that is
+ * if each row has a marking which is on a unique column.
+ *
+ * The marking matrix is read 64 columns at a time, one cache
+ * line of each row, rather than one column at a time, and a
+ * group is left as soon as all of its columns are covered.
+ *
+ * @param   n            The table's height
+ * @param   m            The table's width
+ * @param   marks        The marking matrix
+ * @param   col_covered  Column cover set
+ * @param   stats        Performance counters, may be `NULL`
+ * @return               Whether the marking is complete
+ */
+static Boolean
+kuhn_is_done(size_t n, size_t m, Mark **marks, Cover col_covered[COVER_LIMBS(m)], KuhnStats *stats)
+{
+	size_t i, j, b, end, count = 0;
+	const Mark *marksi;
+
+	memset(col_covered, 0, COVER_LIMBS(m) * sizeof(*col_covered));
+
+	for (b = 0; b < COVER_LIMBS(m); b++) {
+		end = (b << 6) + 64 < m ? (b << 6) + 64 : m;
+		for (i = 0; i < n && col_covered[b] != COVER_VALID(m, b); i++) {
+			marksi = marks[i];
+			for (j = b << 6; j < end; j++) {
+				if (marksi[j] == MARKED) {
+					COVER(col_covered, j);
+					count++;
+				}
+			}
+		}
+		STAT(stats, cells_scanned, i * (end - (b << 6)));
+	}
+
+	return count == n;
+}
+
+
+/**
+ * Create a matrix with marking of cells in the table whose
+ * value is zero [minimal for the row]. Each marking will
+ * be on an unique row and an unique column.
+ * 
+ * The deadline is checked after each tile of rows; the
+ * markings made before it was reached are kept.
+ * 
+ * @param   n            The table's height
+ * @param   m            The table's width
+ * @param   t            The table in which to perform the reduction
+ * @param   marks        Output matrix, of markings as described in
+ *                       the summary, must be all `UNMARKED`
+ * @param   row_covered  Scratch row cover set, must be cleared,
+ *                       and is cleared on return
+ * @param   col_covered  Scratch column cover set, must be cleared,
+ *                       and is cleared on return
+ * @param   deadline     The deadline, may be `NULL`
+ * @param   stats        Performance counters, may be `NULL`
+ * @return               Whether the marking was completed, 0 if
+ *                       the deadline was reached first
+ */
+static Boolean
+kuhn_mark(size_t n, size_t m, Cell **t, Mark **marks, Cover row_covered[COVER_LIMBS(n)],
+          Cover col_covered[COVER_LIMBS(m)], const struct timespec *deadline, KuhnStats *stats)
+{
+	size_t i, j, rows = TILE_ROWS(m);
+
+	for (i = 0; i < n; i++) {
+		if (i % rows == 0 && i && kuhn_expired(deadline))
+			break;
+		for (j = 0; j < m; j++) {
+			if (!COVERED(row_covered, i) && !COVERED(col_covered, j) && !t[i][j]) {
+				marks[i][j] = MARKED;
+				COVER(row_covered, i);
+				COVER(col_covered, j);
+			}
+		}
+	}
+
+	STAT(stats, cells_scanned, i * m);
+
+	memset(row_covered, 0, COVER_LIMBS(n) * sizeof(*row_covered));
+	memset(col_covered, 0, COVER_LIMBS(m) * sizeof(*col_covered));
+	return i == n;
+}
+
+
+/**
+ * Adds a zero to, or removes it from, the bit set of uncovered zeroes
+ *
+ * @param  zeroes     The bit set of uncovered zeroes
+ * @param  uncovered  Whether the zero is uncovered
+ * @param  index      The zero's index in the bit set
+ * @param  stats      Performance counters, may be `NULL`
+ */
+static void
+kuhn_track_zero(BitSet *zeroes, Boolean uncovered, size_t index, KuhnStats *stats)
+{
+	if (uncovered) {
+		bitset_set(zeroes, index);
+		STAT(stats, bitset_sets, 1);
+	} else {
+		bitset_unset(zeroes, index);
+		STAT(stats, bitset_unsets, 1);
+	}
+}
+
+
+/**
+ * Finds a prime
+ * 
+ * @param   n            The table's height
+ * @param   m            The table's width
+ * @param   t            The table
+ * @param   marks        The marking matrix
+ * @param   row_covered  Row cover set
+ * @param   col_covered  Column cover set
+ * @param   zeroes       Bit set with `n * m` bits of the uncovered zeroes,
+ *                       must be empty if `scan` is set, and is empty on return
+ * @param   scan         Whether to scan the table for the uncovered zeroes,
+ *                       if not, `zeroes` must already hold them
+ * @param   col_zeroes   Column-major index of the zeroes, may be `NULL`
+ * @param   primep       Output parameter for the row and column of the found prime
+ * @param   stats        Performance counters, may be `NULL`
+ * @return               1 if a prime was found, 0 otherwise
+ */
+static Boolean
+kuhn_find_prime(size_t n, size_t m, Cell **t, Mark **marks, Cover row_covered[COVER_LIMBS(n)],
+                Cover col_covered[COVER_LIMBS(m)], BitSet *zeroes, Boolean scan, const Cover *col_zeroes,
+                CellPosition *primep, KuhnStats *stats)
+{
+	size_t i, j, b, row, col;
+	ssize_t p;
+	Boolean mark_in_row;
+	Cover uncovered, bits;
+	const Cell *ti;
+	const Cover *zc;
+
+	STAT(stats, find_prime_calls, 1);
+
+	for (i = 0; scan && i < n; i++) {
+		if (COVERED(row_covered, i))
+			continue;
+		ti = t[i];
+		for (b = 0; b < COVER_LIMBS(m); b++) {
+			uncovered = ~col_covered[b] & COVER_VALID(m, b);
+			for (; uncovered; uncovered &= uncovered - 1) {
+				j = (b << 6) + LOWEST_BIT(uncovered);
+				if (!ti[j]) {
+					bitset_set(zeroes, i * m + j);
+					STAT(stats, bitset_sets, 1);
+				}
+				STAT(stats, cells_scanned, 1);
+			}
+		}
+	}
+
+	for (;;) {
+		p = bitset_any(zeroes);
+		if (p < 0)
+			return 0;
+
+		row = (size_t)p / m;
+		col = (size_t)p % m;
+	
+		marks[row][col] = PRIME;
+	
+		mark_in_row = 0;
+		for (j = 0; j < m; j++) {
+			if (marks[row][j] == MARKED) {
+				mark_in_row = 1;
+				col = j;
+			}
+		}
+		STAT(stats, cells_scanned, m);
+
+		if (mark_in_row) {
+			COVER(row_covered, row);
+			UNCOVER(col_covered, col);
+
+			if (col_zeroes) {
+				zc = &col_zeroes[col * COVER_LIMBS(n)];
+				for (b = 0; b < COVER_LIMBS(n); b++) {
+					for (bits = zc[b]; bits; bits &= bits - 1) {
+						i = (b << 6) + LOWEST_BIT(bits);
+						if (i != row)
+							kuhn_track_zero(zeroes, !COVERED(row_covered, i), i * m + col, stats);
+					}
+				}
+			} else {
+				for (i = 0; i < n; i++)
+					if (!t[i][col] && row != i)
+						kuhn_track_zero(zeroes, !COVERED(row_covered, i), i * m + col, stats);
+				STAT(stats, cells_scanned, n);
+			}
+
+			for (j = 0; j < m; j++)
+				if (!t[row][j] && col != j)
+					kuhn_track_zero(zeroes, !COVERED(row_covered, row) && !COVERED(col_covered, j),
+					                row * m + j, stats);
+
+			kuhn_track_zero(zeroes, !COVERED(row_covered, row) && !COVERED(col_covered, col),
+			                row * m + col, stats);
+
+			STAT(stats, cells_scanned, m);
+		} else {
+			bitset_clear(zeroes);
+			primep->row = row;
+			primep->col = col;
+			return 1;
+		}
+	}
+}
+
+
+/**
+ * Removes all prime marks and modifies the marking
+ *
+ * @param  n           The table's height
+ * @param  m           The table's width
+ * @param  marks       The marking matrix
+ * @param  alt         Marking modification path
+ * @param  col_marks   Markings in the columns
+ * @param  row_primes  Primes in the rows
+ * @param  prime       The last found prime
+ * @param  stats       Performance counters, may be `NULL`
+ */
+static void
+kuhn_alt_marks(size_t n, size_t m, Mark **marks, CellPosition alt[2 * n + 1],
+               KuhnIndex col_marks[m], KuhnIndex row_primes[n], const CellPosition *prime, KuhnStats *stats)
+{
+	size_t i, j, index = 0;
+	KuhnIndex row;
+	Mark *markx, *marksi;
+
+	alt[0].row = prime->row;
+	alt[0].col = prime->col;
+
+	for (i = 0; i < n; i++)
+		row_primes[i] = NO_INDEX;
+
+	for (i = 0; i < m; i++)
+		col_marks[i] = NO_INDEX;
+
+	/* The primes are removed as they are recorded, the path
+	 * is found from `row_primes` without looking at them */
+	for (i = 0; i < n; i++) {
+		marksi = marks[i];
+		for (j = 0; j < m; j++) {
+			if (marksi[j] == MARKED) {
+				col_marks[j] = (KuhnIndex)i;
+			} else if (marksi[j] == PRIME) {
+				row_primes[i] = (KuhnIndex)j;
+				marksi[j] = UNMARKED;
+			}
+		}
+	}
+
+	while ((row = col_marks[alt[index].col]) != NO_INDEX) {
+		index++;
+		alt[index].row = row;
+		alt[index].col = alt[index - 1].col;
+
+		index++;
+		alt[index].row = row;
+		alt[index].col = row_primes[row];
+	}
+
+	for (i = 0; i <= index; i++) {
+		markx = &marks[alt[i].row][alt[i].col];
+		*markx = *markx == MARKED ? UNMARKED : MARKED;
+	}
+
+	PROBE1(augment, index + 1);
+	STAT(stats, augmentations, 1);
+	STAT(stats, path_cells, index + 1);
+	STAT(stats, cells_scanned, n * m + index + 1);
+}
+
+
+/**
+ * Depending on whether the cells' rows and columns are covered,
+ * the the minimum value in the table is added, subtracted or
+ * neither from the cells.
+ *
+ * This is the same as adding the minimum value to the potentials
+ * of the uncovered rows and subtracting it from the potentials
+ * of the covered columns, which is done to `u` and `v`.
+ *
+ * The columns are visited 64 at a time, a group of columns that
+ * are all covered, or all uncovered, is handled with a single
+ * test, and a group that is only partially covered only visits
+ * the columns it has to.
+ *
+ * The uncovered zeroes this creates are added to `zeroes` in the
+ * same pass, while the cells are still in the cache, so that the
+ * next `kuhn_find_prime` does not need to scan the table for them;
+ * there are no uncovered zeroes before the call, so they are the
+ * uncovered cells that held the minimum.
+ *
+ * The table is updated a tile at a time, and the least uncovered
+ * cell of each tile is found in the same pass, for the next call.
+ * Until the next augmentation, `kuhn_find_prime` only covers rows
+ * and uncovers columns, so the next call only has to scan the
+ * tiles in which a row has been covered, and the newly uncovered
+ * columns, rather than the whole table, to find the minimum.
+ *
+ * @param  n      The table's height
+ * @param  m      The table's width
+ * @param  t      The table to manipulate
+ * @param  work   The working memory, with the cover sets, the bit set
+ *                of uncovered zeroes, which must be empty, and the
+ *                column-major index of the zeroes, which is kept up to date
+ * @param  u      Row potentials
+ * @param  v      Column potentials
+ * @param  carry  Whether the minima of the tiles were left by a call
+ *                since the last augmentation, and can be reused
+ * @param  stats  Performance counters, may be `NULL`
+ */
+static void
+kuhn_add_and_subtract(size_t n, size_t m, Cell **t, KuhnWork *work, Cell u[n], Cell v[m],
+                      Boolean carry, KuhnStats *stats)
+{
+	Cover *row_covered = work->row_covered, *col_covered = work->col_covered;
+	Cover *col_zeroes = work->col_zeroes, *tile_dirty = work->tile_dirty;
+	Cell *tile_min = work->tile_min;
+	size_t i, j, k, b, blocks = COVER_LIMBS(m), limbs = COVER_LIMBS(n);
+	size_t rows = TILE_ROWS(m), tiles = TILE_COUNT(n, m), tile, end;
+	Cell min = CELL_MAX, delta, *ti;
+	Cover cols, bits, flip;
+	Boolean covered;
+
+	STAT(stats, add_and_subtract_rounds, 1);
+
+	if (carry) {
+		for (b = 0; b < limbs; b++)
+			for (bits = row_covered[b] & ~work->seen_row_covered[b]; bits; bits &= bits - 1)
+				COVER(tile_dirty, ((b << 6) + LOWEST_BIT(bits)) / rows);
+		for (b = 0; b < blocks; b++) {
+			for (bits = work->seen_col_covered[b] & ~col_covered[b]; bits; bits &= bits - 1) {
+				j = (b << 6) + LOWEST_BIT(bits);
+				for (i = 0; i < n; i++) {
+					tile = i / rows;
+					if (COVERED(row_covered, i) || COVERED(tile_dirty, tile))
+						continue;
+					if (tile_min[tile] > t[i][j])
+						tile_min[tile] = t[i][j];
+					STAT(stats, cells_scanned, 1);
+				}
+			}
+		}
+	} else {
+		memset(tile_dirty, ~0, COVER_LIMBS(tiles) * sizeof(Cover));
+	}
+
+	for (tile = 0; tile < tiles; tile++) {
+		if (COVERED(tile_dirty, tile)) {
+			tile_min[tile] = CELL_MAX;
+			end = (tile + 1) * rows < n ? (tile + 1) * rows : n;
+			for (i = tile * rows; i < end; i++) {
+				if (COVERED(row_covered, i))
+					continue;
+				for (b = 0; b < blocks; b++) {
+					cols = ~col_covered[b] & COVER_VALID(m, b);
+					ti = &t[i][b << 6];
+					if (cols == ~(Cover)0) {
+						for (j = 0; j < 64; j++)
+							if (tile_min[tile] > ti[j])
+								tile_min[tile] = ti[j];
+						STAT(stats, cells_scanned, 64);
+					} else {
+						for (; cols; cols &= cols - 1) {
+							j = LOWEST_BIT(cols);
+							if (tile_min[tile] > ti[j])
+								tile_min[tile] = ti[j];
+							STAT(stats, cells_scanned, 1);
+						}
+					}
+				}
+			}
+			if (stats)
+				stats->tiles_scanned += 1;
+		}
+		if (min > tile_min[tile])
+			min = tile_min[tile];
+	}
+	memset(tile_dirty, 0, COVER_LIMBS(tiles) * sizeof(Cover));
+
+	/* Covered cells in covered rows gain `min`, and uncovered
+	 * cells in uncovered rows lose it, the others are unchanged */
+	for (tile = 0; tile < tiles; tile++) {
+		tile_min[tile] = CELL_MAX;
+		end = (tile + 1) * rows < n ? (tile + 1) * rows : n;
+		for (i = tile * rows; i < end; i++) {
+			covered = COVERED(row_covered, i);
+			delta = covered ? min : -min;
+			flip = covered ? 0 : ~(Cover)0;
+			for (b = 0; b < blocks; b++) {
+				cols = (col_covered[b] ^ flip) & COVER_VALID(m, b);
+				ti = &t[i][b << 6];
+				if (cols == ~(Cover)0) {
+					for (j = 0; j < 64; j++)
+						ti[j] += delta;
+					STAT(stats, cells_scanned, 64);
+				} else {
+					for (bits = cols; bits; bits &= bits - 1) {
+						ti[LOWEST_BIT(bits)] += delta;
+						STAT(stats, cells_scanned, 1);
+					}
+				}
+				if (covered)
+					continue;
+				for (; cols; cols &= cols - 1) {
+					j = LOWEST_BIT(cols);
+					if (tile_min[tile] > ti[j])
+						tile_min[tile] = ti[j];
+					if (!ti[j]) {
+						bitset_set(&work->zeroes, i * m + (b << 6) + j);
+						STAT(stats, bitset_sets, 1);
+						if (col_zeroes)
+							COVER(&col_zeroes[((b << 6) + j) * limbs], i);
+					}
+				}
+			}
+		}
+		if (stats)
+			stats->tiles_updated += 1;
+	}
+	memcpy(work->seen_row_covered, row_covered, limbs * sizeof(Cover));
+	memcpy(work->seen_col_covered, col_covered, blocks * sizeof(Cover));
+
+	/* The doubly covered cells gained `min`, so none of them is a zero */
+	for (j = 0; col_zeroes && j < m; j++)
+		if (COVERED(col_covered, j))
+			for (k = 0; k < limbs; k++)
+				col_zeroes[j * limbs + k] &= ~row_covered[k];
+	PROBE1(add_and_subtract, min);
+
+	for (i = 0; i < n; i++)
+		if (!COVERED(row_covered, i))
+			u[i] += min;
+	for (j = 0; j < m; j++)
+		if (COVERED(col_covered, j))
+			v[j] -= min;
+}
+
+
+/**
+ * Creates a list of the assignment cells
+ * 
+ * @param  n           The table's height
+ * @param  m           The table's width
+ * @param  marks       Matrix markings
+ * @param  col_of_row  Output array for the assignment, the column
+ *                     assigned to each row, `m` if none is
+ */
+static void
+kuhn_assign(size_t n, size_t m, Mark **marks, KuhnIndex col_of_row[n])
+{
+	size_t i, j;
+
+	for (i = 0; i < n; i++) {
+		col_of_row[i] = (KuhnIndex)m;
+		for (j = 0; j < m; j++) {
+			if (marks[i][j] == MARKED) {
+				col_of_row[i] = (KuhnIndex)j;
+				break;
+			}
+		}
+	}
+}
+
+
+/**
+ * Completes a partial assignment by greedily assigning each
+ * unassigned row to the cheapest column that is still free
+ *
+ * @param  n           The table's height
+ * @param  m           The table's width
+ * @param  t           The reduced table
+ * @param  v           Column potentials, `t[i][j] + u[i] + v[j]` is the cost
+ *                     of a cell, where `u[i]`, the same for the whole row,
+ *                     does not take part in choosing a column
+ * @param  col_of_row  The assignment, unassigned rows have the column `m`
+ * @param  taken       Scratch cover set of the columns, must be cleared
+ */
+static void
+kuhn_complete(size_t n, size_t m, Cell **t, const Cell v[m], KuhnIndex col_of_row[n],
+              Cover taken[COVER_LIMBS(m)])
+{
+	size_t i, j, best;
+	Cell min, cost;
+	const Cell *ti;
+
+	for (i = 0; i < n; i++)
+		if (col_of_row[i] < m)
+			COVER(taken, col_of_row[i]);
+
+	for (i = 0; i < n; i++) {
+		if (col_of_row[i] < m)
+			continue;
+		ti = t[i];
+		best = m;
+		min = CELL_MAX;
+		for (j = 0; j < m; j++) {
+			cost = ti[j] + v[j];
+			if ((best == m || min > cost) && !COVERED(taken, j)) {
+				min = cost;
+				best = j;
+			}
+		}
+		COVER(taken, best);
+		col_of_row[i] = (KuhnIndex)best;
+	}
+}
+
+
+/**
+ * Allocates memory with malloc(3), or posix_memalign(3)
+ * if malloc(3) does not guarantee the alignment
+ *
+ * @param   data       Unused
+ * @param   size       The number of bytes to allocate
+ * @param   alignment  The required alignment
+ * @return             The memory, `NULL` on failure
+ */
+static void *
+default_allocate(void *data, size_t size, size_t alignment)
+{
+	void *ptr;
+
+	(void) data;
+	if (alignment <= sizeof(Cell))
+		return malloc(size);
+	return posix_memalign(&ptr, alignment, size) ? NULL : ptr;
+}
+
+
+/**
+ * Deallocates memory allocated with `default_allocate`
+ *
+ * @param  data       Unused
+ * @param  ptr        The memory
+ * @param  size       Unused
+ * @param  alignment  Unused
+ */
+static void
+default_deallocate(void *data, void *ptr, size_t size, size_t alignment)
+{
+	(void) data;
+	(void) size;
+	(void) alignment;
+	free(ptr);
+}
+
+
+const KuhnAllocator kuhn_default_allocator = {default_allocate, default_deallocate, NULL};
+
+
+void *
+kuhn_allocate(const KuhnAllocator *allocator, size_t size, size_t alignment)
+{
+	void *ptr = allocator->allocate(allocator->data, size + !size, alignment);
+	if (!ptr)
+		errno = ENOMEM;
+	return ptr;
+}
+
+
+void
+kuhn_deallocate(const KuhnAllocator *allocator, void *ptr, size_t size, size_t alignment)
+{
+	if (ptr)
+		allocator->deallocate(allocator->data, ptr, size + !size, alignment);
+}
+
+
+/**
+ * Lays out the working memory of `kuhn_solve`
+ *
+ * @param   n        The table's height
+ * @param   m        The table's width
+ * @param   offsets  Output array for the offset of each array,
+ *                   in the order they are listed in `KuhnWork`
+ * @return           The size of the block, 0 if it is too large
+ */
+static size_t
+kuhn_work_layout(size_t n, size_t m, size_t offsets[13])
+{
+	size_t c = n * m / 64 + !!(n * m % 64);
+	size_t sizes[13], total = 0, i;
+
+	if (m && n > (SIZE_MAX / 2 - CACHE_LINE * 16) / m / sizeof(CellPosition))
+		return 0;
+
+	sizes[0] = COVER_LIMBS(n) * sizeof(Cover);
+	sizes[1] = COVER_LIMBS(m) * sizeof(Cover);
+	sizes[2] = n * sizeof(KuhnIndex);
+	sizes[3] = m * sizeof(KuhnIndex);
+	sizes[4] = (2 * n + 1) * sizeof(CellPosition);
+	sizes[5] = c * sizeof(BitSetLimb);
+	sizes[6] = 2 * (c + 1) * sizeof(size_t);
+	sizes[7] = n * sizeof(Mark *) + n * m * sizeof(Mark);
+	sizes[8] = n >= HUNGARIAN_TRANSPOSE_MIN ? m * COVER_LIMBS(n) * sizeof(Cover) : 0;
+	sizes[9] = TILE_COUNT(n, m) * sizeof(Cell);
+	sizes[10] = COVER_LIMBS(TILE_COUNT(n, m)) * sizeof(Cover);
+	sizes[11] = COVER_LIMBS(n) * sizeof(Cover);
+	sizes[12] = COVER_LIMBS(m) * sizeof(Cover);
+	for (i = 0; i < 13; i++) {
+		offsets[i] = total;
+		total += ROUND_LINE(sizes[i]);
+	}
+
+	return total;
+}
+
+
+/**
+ * Allocates the working memory of `kuhn_solve`
+ *
+ * @param   this       Output parameter for the working memory,
+ *                     all of which is zeroed
+ * @param   n          The table's height
+ * @param   m          The table's width
+ * @param   allocator  The allocator
+ * @return             0 on success, -1 on error
+ */
+static int
+kuhn_work_create(KuhnWork *this, size_t n, size_t m, const KuhnAllocator *allocator)
+{
+	size_t c = n * m / 64 + !!(n * m % 64);
+	size_t offsets[13], total, i;
+	char *block;
+
+	if (!(total = kuhn_work_layout(n, m, offsets))) {
+		errno = ENOMEM;
+		return -1;
+	}
+
+	if (!(this->block = kuhn_allocate(allocator, total, CACHE_LINE)))
+		return -1;
+	this->size = total;
+	block = this->block;
+	memset(block, 0, total);
+
+	this->row_covered      = (Cover *)(void *)&block[offsets[0]];
+	this->col_covered      = (Cover *)(void *)&block[offsets[1]];
+	this->row_primes       = (KuhnIndex *)(void *)&block[offsets[2]];
+	this->col_marks        = (KuhnIndex *)(void *)&block[offsets[3]];
+	this->alt              = (CellPosition *)(void *)&block[offsets[4]];
+	this->zeroes.limbs     = (BitSetLimb *)(void *)&block[offsets[5]];
+	this->zeroes.prev      = (size_t *)(void *)&block[offsets[6]];
+	this->zeroes.next      = &this->zeroes.prev[c + 1];
+	this->zeroes.first     = 0;
+	this->marks            = (Mark **)(void *)&block[offsets[7]];
+	this->col_zeroes       = n >= HUNGARIAN_TRANSPOSE_MIN ? (Cover *)(void *)&block[offsets[8]] : NULL;
+	this->tile_min         = (Cell *)(void *)&block[offsets[9]];
+	this->tile_dirty       = (Cover *)(void *)&block[offsets[10]];
+	this->seen_row_covered = (Cover *)(void *)&block[offsets[11]];
+	this->seen_col_covered = (Cover *)(void *)&block[offsets[12]];
+	for (i = 0; i < n; i++)
+		this->marks[i] = &((Mark *)(void *)&this->marks[n])[i * m];
+
+	return 0;
+}
+
+
+/**
+ * Memory that `kuhn_solve_in` allocates from
+ */
+typedef struct {
+	char *next;
+	char *end;
+} Bump;
+
+
+/**
+ * Allocates from a `Bump`, every allocation is
+ * aligned to, and a multiple of, `CACHE_LINE`
+ *
+ * @param   data       The `Bump`
+ * @param   size       The number of bytes to allocate
+ * @param   alignment  The required alignment, at most `CACHE_LINE`
+ * @return             The memory, `NULL` if there is not enough left
+ */
+static void *
+bump_allocate(void *data, size_t size, size_t alignment)
+{
+	Bump *this = data;
+	uintptr_t p = ((uintptr_t)this->next + (CACHE_LINE - 1)) & ~(uintptr_t)(CACHE_LINE - 1);
+
+	(void) alignment;
+	if (p > (uintptr_t)this->end || ROUND_LINE(size) > (uintptr_t)this->end - p)
+		return NULL;
+	this->next = (char *)p + ROUND_LINE(size);
+	return (void *)p;
+}
+
+
+/**
+ * Deallocation that does nothing, for memory from a `Bump`
+ *
+ * @param  data       Unused
+ * @param  ptr        Unused
+ * @param  size       Unused
+ * @param  alignment  Unused
+ */
+static void
+bump_deallocate(void *data, void *ptr, size_t size, size_t alignment)
+{
+	(void) data;
+	(void) ptr;
+	(void) size;
+	(void) alignment;
+}
+
+
+/**
+ * The allocator of results from `kuhn_solve_in`, for `kuhn_result_destroy`
+ */
+static const KuhnAllocator bump_allocator = {bump_allocate, bump_deallocate, NULL};
+
+
+#if defined(HUNGARIAN_MAX_N) && defined(HUNGARIAN_MAX_M)
+/**
+ * The memory `kuhn_solve` uses if it is not given an allocator
+ */
+static union {
+	char buf[KUHN_WORKSPACE_MAX];
+	Cell align;
+} static_workspace;
+#endif
+
+
+Boolean
+kuhn_expired(const struct timespec *deadline)
+{
+	struct timespec now;
+
+	if (!deadline)
+		return 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if (now.tv_sec != deadline->tv_sec)
+		return now.tv_sec > deadline->tv_sec;
+	return now.tv_nsec >= deadline->tv_nsec;
+}
+
+
+int
+kuhn_solve(size_t n, size_t m, Cell **table, const KuhnOptions *options, KuhnResult *result)
+{
+	size_t i;
+	KuhnWork work;
+	CellPosition prime;
+	Cell *u, *v;
+	const KuhnAllocator *allocator = options && options->allocator ? options->allocator : &kuhn_default_allocator;
+	const struct timespec *deadline = options ? options->deadline : NULL;
+	Boolean maximize = options ? options->maximize : 0;
+	KuhnStats *stats = options ? options->stats : NULL;
+	KuhnTrace *trace = options ? options->trace : NULL;
+	uint_fast64_t start = trace ? kuhn_now() : 0;
+	Boolean done, found, scan, completed = 1;
+
+	/* With more rows than columns, a row could never be
+	 * assigned and the search would not end */
+	if (n > m) {
+		errno = EINVAL;
+		return -1;
+	}
+
+#if defined(HUNGARIAN_MAX_N) && defined(HUNGARIAN_MAX_M)
+	if (allocator == &kuhn_default_allocator) {
+		if (n > HUNGARIAN_MAX_N || m > HUNGARIAN_MAX_M) {
+			errno = ENOMEM;
+			return -1;
+		}
+		return kuhn_solve_in(n, m, table, options, &static_workspace, sizeof(static_workspace), result);
+	}
+#endif
+
+	if (n >= KUHN_INDEX_MAX || m >= KUHN_INDEX_MAX) {
+		errno = ERANGE;
+		return -1;
+	}
+
+	PROBE2(solve_start, n, m);
+
+	/* Not copying table since it will only be used once. */
+
+	if (stats)
+		memset(stats, 0, sizeof(*stats));
+
+	/* The result is returned to the caller, who frees its
+	 * arrays separately, everything else is in `work` */
+	result->allocator = allocator;
+	result->height = n;
+	result->width = m;
+	result->row_potential = u = kuhn_allocate(allocator, n * sizeof(Cell), sizeof(Cell));
+	result->col_potential = v = kuhn_allocate(allocator, m * sizeof(Cell), sizeof(Cell));
+	result->col_of_row = kuhn_allocate(allocator, n * sizeof(KuhnIndex), sizeof(KuhnIndex));
+	if (!u || !v || !result->col_of_row || kuhn_work_create(&work, n, m, allocator)) {
+		kuhn_result_destroy(result);
+		return -1;
+	}
+	memset(u, 0, n * sizeof(Cell));
+	memset(v, 0, m * sizeof(Cell));
+
+	/* The reduction is always completed, so that the potentials
+	 * are dual feasible and every cell's cost can be recovered */
+	result->optimal = 0;
+	TIMED(options, KUHN_PHASE_REDUCE, kuhn_reduce_rows(n, m, table, u, maximize, stats));
+	if (kuhn_expired(deadline))
+		goto timeout;
+	if (work.col_zeroes)
+		TIMED(options, KUHN_PHASE_REDUCE,
+		      completed = kuhn_index_zeroes(n, m, table, work.col_zeroes, deadline, stats));
+	if (!completed)
+		goto timeout;
+	TIMED(options, KUHN_PHASE_MARK,
+	      completed = kuhn_mark(n, m, table, work.marks, work.row_covered, work.col_covered, deadline, stats));
+	if (!completed)
+		goto timeout;
+
+	for (;;) {
+		if (kuhn_expired(deadline))
+			goto timeout;
+		TIMED(options, KUHN_PHASE_IS_DONE, done = kuhn_is_done(n, m, work.marks, work.col_covered, stats));
+		if (done)
+			break;
+		scan = 1;
+		for (;;) {
+			if (kuhn_expired(deadline))
+				goto timeout;
+			TIMED(options, KUHN_PHASE_FIND_PRIME,
+			      found = kuhn_find_prime(n, m, table, work.marks, work.row_covered, work.col_covered,
+			                              &work.zeroes, scan, work.col_zeroes, &prime, stats));
+			if (found)
+				break;
+			TIMED(options, KUHN_PHASE_ADD_AND_SUBTRACT,
+			      kuhn_add_and_subtract(n, m, table, &work, u, v, !scan, stats));
+			scan = 0;
+		}
+		TIMED(options, KUHN_PHASE_ALT_MARKS,
+		      kuhn_alt_marks(n, m, work.marks, work.alt, work.col_marks, work.row_primes, &prime, stats));
+		memset(work.row_covered, 0, COVER_LIMBS(n) * sizeof(*work.row_covered));
+		memset(work.col_covered, 0, COVER_LIMBS(m) * sizeof(*work.col_covered));
+	}
+
+	result->optimal = 1;
+
+timeout:
+	TIMED(options, KUHN_PHASE_ASSIGN, kuhn_assign(n, m, work.marks, result->col_of_row));
+	if (!result->optimal) {
+		memset(work.col_covered, 0, COVER_LIMBS(m) * sizeof(*work.col_covered));
+		TIMED(options, KUHN_PHASE_ASSIGN,
+		      kuhn_complete(n, m, table, v, result->col_of_row, work.col_covered));
+	}
+
+	kuhn_deallocate(allocator, work.block, work.size, CACHE_LINE);
+
+	/* The reduced table is never negative, so the potentials are
+	 * always dual feasible and their sum is a lower bound */
+	result->lower_bound = 0;
+	for (i = 0; i < n; i++)
+		result->lower_bound += u[i];
+	for (i = 0; i < m; i++)
+		result->lower_bound += v[i];
+
+	/* For an optimal assignment, unassigned columns have zero
+	 * potential, so by complementary slackness this is the cost */
+	result->cost = result->lower_bound;
+	if (!result->optimal) {
+		result->cost = 0;
+		for (i = 0; i < n; i++)
+			result->cost += table[i][result->col_of_row[i]] + u[i] + v[result->col_of_row[i]];
+	}
+
+	/* The potentials are for the negated table when maximising */
+	if (maximize) {
+		for (i = 0; i < n; i++)
+			u[i] = -u[i];
+		for (i = 0; i < m; i++)
+			v[i] = -v[i];
+		result->lower_bound = -result->lower_bound;
+		result->cost = -result->cost;
+	}
+
+	if (trace)
+		trace_span(trace, "kuhn_solve", start, kuhn_now());
+	PROBE2(solve_end, n, m);
+	return 0;
+}
+
+
+size_t
+kuhn_workspace_size(size_t n, size_t m)
+{
+	size_t offsets[13], total = kuhn_work_layout(n, m, offsets);
+
+	/* Alignment of the first allocation, the potentials, the assignment, and the working memory */
+	if (!total)
+		return 0;
+	return (CACHE_LINE - 1) + ROUND_LINE(n * sizeof(Cell) + !n) + ROUND_LINE(m * sizeof(Cell) + !m) +
+	       ROUND_LINE(n * sizeof(KuhnIndex) + !n) + total;
+}
+
+
+int
+kuhn_solve_in(size_t n, size_t m, Cell **table, const KuhnOptions *options,
+              void *workspace, size_t size, KuhnResult *result)
+{
+	Bump bump;
+	KuhnAllocator allocator = bump_allocator;
+	KuhnOptions opts = {0};
+
+	bump.next = workspace;
+	bump.end = &bump.next[size];
+	allocator.data = &bump;
+	if (options)
+		opts = *options;
+	opts.allocator = &allocator;
+
+	if (kuhn_solve(n, m, table, &opts, result))
+		return -1;
+	result->allocator = &bump_allocator;
+	return 0;
+}
+
+
+void
+kuhn_result_destroy(KuhnResult *result)
+{
+	const KuhnAllocator *allocator = result->allocator ? result->allocator : &kuhn_default_allocator;
+
+	kuhn_deallocate(allocator, result->col_of_row, result->height * sizeof(KuhnIndex), sizeof(KuhnIndex));
+	kuhn_deallocate(allocator, result->row_potential, result->height * sizeof(Cell), sizeof(Cell));
+	kuhn_deallocate(allocator, result->col_potential, result->width * sizeof(Cell), sizeof(Cell));
+	result->col_of_row = NULL;
+	result->row_potential = NULL;
+	result->col_potential = NULL;
+}
+
+
+CellPosition *
+kuhn_match(size_t n, size_t m, Cell **table)
+{
+#if defined(HUNGARIAN_MAX_N) && defined(HUNGARIAN_MAX_M)
+	static CellPosition assignment[HUNGARIAN_MAX_N + 1];
+#else
+	CellPosition *assignment;
+#endif
+	KuhnResult result;
+	size_t i;
+
+	if (kuhn_solve(n, m, table, NULL, &result))
+		return NULL;
+#if !defined(HUNGARIAN_MAX_N) || !defined(HUNGARIAN_MAX_M)
+	if (!(assignment = malloc((n + !n) * sizeof(*assignment)))) {
+		kuhn_result_destroy(&result);
+		return NULL;
+	}
+#endif
+	for (i = 0; i < n; i++) {
+		assignment[i].row = (KuhnIndex)i;
+		assignment[i].col = result.col_of_row[i];
+	}
+	kuhn_result_destroy(&result);
+	return assignment;
+}
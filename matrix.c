@@ -0,0 +1,809 @@
+/**
+ * 𝓞(n³) implementation of the Hungarian algorithm
+ * 
+ * Copyright (C) 2011, 2014, 2020  Mattias Andrée
+ * 
+ * This program is free software. It comes without any warranty, to
+ * the extent permitted by applicable law. You can redistribute it
+ * and/or modify it under the terms of the Do What The Fuck You Want
+ * To Public License, Version 2, as published by Sam Hocevar. See
+ * http://sam.zoy.org/wtfpl/COPYING for more details.
+ */
+
+
+#include "matrix.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+
+/**
+ * Reads a little-endian integer
+ *
+ * @param   p     The integer's bytes
+ * @param   size  The number of bytes
+ * @return        The integer
+ */
+static uint64_t
+get_le(const unsigned char *p, size_t size)
+{
+	uint64_t value = 0;
+	while (size--)
+		value = value << 8 | p[size];
+	return value;
+}
+
+
+/**
+ * Writes a little-endian integer
+ *
+ * @param  p      Output buffer for the integer's bytes
+ * @param  value  The integer
+ * @param  size   The number of bytes
+ */
+static void
+put_le(unsigned char *p, uint64_t value, size_t size)
+{
+	for (; size--; value >>= 8)
+		*p++ = (unsigned char)value;
+}
+
+
+/**
+ * Checks whether the host stores `Cell`s as little-endian 64-bit integers
+ *
+ * @return  Whether binary `MATRIX_INT64` cells can be used as is
+ */
+static Boolean
+native_int64(void)
+{
+	Cell one = 1;
+	return sizeof(Cell) == 8 && *(unsigned char *)&one == 1;
+}
+
+
+/**
+ * The allocator set with `matrix_set_allocator`
+ */
+static const KuhnAllocator *cell_allocator = NULL;
+
+
+void
+matrix_set_allocator(const KuhnAllocator *allocator)
+{
+	cell_allocator = allocator;
+}
+
+
+/**
+ * Deallocates the cells of a table that is not a file mapping
+ *
+ * @param  this  The table
+ */
+static void
+free_data(Matrix *this)
+{
+	if (this->allocator && this->data)
+		this->allocator->deallocate(this->allocator->data, this->data, this->data_size, sizeof(Cell));
+	else if (!this->allocator)
+		free(this->data);
+	this->data = NULL;
+	this->data_size = 0;
+}
+
+
+/**
+ * Allocates a table
+ *
+ * @param   this  Output parameter for the table
+ * @param   n     The height of the table
+ * @param   m     The width of the table
+ * @return        0 on success, -1 on error
+ */
+static int
+matrix_alloc(Matrix *this, size_t n, size_t m)
+{
+	this->rows = NULL;
+	this->data = NULL;
+	this->map_size = 0;
+	this->allocator = NULL;
+	this->data_size = 0;
+	if (matrix_resize(this, n, m)) {
+		free_data(this);
+		free(this->rows);
+		this->rows = NULL;
+		return -1;
+	}
+	return 0;
+}
+
+
+int
+matrix_resize(Matrix *this, size_t n, size_t m)
+{
+	void *data, *rows;
+	size_t i, size;
+
+	if (m && n > SIZE_MAX / m / sizeof(Cell)) {
+		errno = ENOMEM;
+		return -1;
+	}
+	size = n * m * sizeof(Cell) + 1;
+
+	if (!this->data)
+		this->allocator = cell_allocator;
+	if (!this->allocator) {
+		if (!(data = realloc(this->data, size)))
+			return -1;
+		this->data = data;
+	} else if (size > this->data_size) {
+		free_data(this);
+		if (!(this->data = this->allocator->allocate(this->allocator->data, size, sizeof(Cell)))) {
+			errno = ENOMEM;
+			return -1;
+		}
+		this->data_size = size;
+	}
+	if (!(rows = realloc(this->rows, (n + !n) * sizeof(Cell *))))
+		return -1;
+	this->rows = rows;
+
+	this->n = n;
+	this->m = m;
+	for (i = 0; i < n; i++)
+		this->rows[i] = &((Cell *)this->data)[i * m];
+	return 0;
+}
+
+
+int
+matrix_random(Matrix *this, size_t n, size_t m)
+{
+	size_t i, j;
+
+	if (matrix_alloc(this, n, m))
+		return -1;
+	for (i = 0; i < n; i++)
+		for (j = 0; j < m; j++)
+			this->rows[i][j] = (Cell)(random() & 63);
+	return 0;
+}
+
+
+/**
+ * A part of a text matrix, parsed by one thread
+ */
+typedef struct {
+	/**
+	 * The beginning of the text
+	 */
+	const char *begin;
+
+	/**
+	 * The end of the text
+	 */
+	const char *end;
+
+	/**
+	 * The number of integers in the text
+	 */
+	size_t count;
+
+	/**
+	 * The index of the first integer in the text among all integers
+	 */
+	size_t offset;
+
+	/**
+	 * Output array for all integers
+	 */
+	Cell *cells;
+
+	/**
+	 * The number of integers to store
+	 */
+	size_t total;
+
+	/**
+	 * 0 on success, otherwise an `errno` value
+	 */
+	int error;
+} TextChunk;
+
+
+const char *
+matrix_parse_cell(const char *p, const char *end, Cell *cellp)
+{
+	Boolean negative = *p == '-';
+	uint64_t value, limit;
+	unsigned digit;
+
+	if (*p == '-' || *p == '+')
+		p++;
+	limit = negative ? (uint64_t)CELL_MAX + 1 : (uint64_t)CELL_MAX;
+	if (p == end || (unsigned)(*p - '0') > 9)
+		goto invalid;
+
+	for (value = 0; p != end && (digit = (unsigned)(*p - '0')) <= 9; p++) {
+		if (value > (limit - digit) / 10) {
+			errno = ERANGE;
+			return NULL;
+		}
+		value = value * 10 + digit;
+	}
+	if (p != end && !IS_SPACE(*p))
+		goto invalid;
+
+	*cellp = negative ? (Cell)(0 - value) : (Cell)value;
+	return p;
+
+invalid:
+	errno = EINVAL;
+	return NULL;
+}
+
+
+/**
+ * Counts the integers in a part of a text matrix
+ *
+ * @param   arg  The part, as a `TextChunk *`
+ * @return       `NULL`
+ */
+static void *
+text_count(void *arg)
+{
+	TextChunk *this = arg;
+	const char *p = this->begin, *end = this->end;
+	size_t count = 0;
+	Boolean space = 1;
+
+	for (; p != end; p++) {
+		count += space && !IS_SPACE(*p);
+		space = IS_SPACE(*p);
+	}
+
+	this->count = count;
+	return NULL;
+}
+
+
+/**
+ * Parses the integers in a part of a text matrix
+ *
+ * @param   arg  The part, as a `TextChunk *`
+ * @return       `NULL`
+ */
+static void *
+text_parse(void *arg)
+{
+	TextChunk *this = arg;
+	const char *p = this->begin, *end = this->end;
+	size_t index = this->offset;
+
+	for (; index < this->total; index++) {
+		while (p != end && IS_SPACE(*p))
+			p++;
+		if (p == end)
+			break;
+
+		if (!(p = matrix_parse_cell(p, end, &this->cells[index]))) {
+			this->error = errno;
+			break;
+		}
+	}
+
+	return NULL;
+}
+
+
+/**
+ * Reads all remaining input from a file descriptor, or
+ * maps it if it is a regular file
+ *
+ * @param   fd         The file descriptor
+ * @param   sizep      Output parameter for the number of bytes
+ * @param   basep      Output parameter for the memory to release
+ * @param   map_sizep  Output parameter for the size of the mapping,
+ *                     0 if the memory is allocated
+ * @return             The input, `NULL` on error
+ */
+static const char *
+read_all(int fd, size_t *sizep, void **basep, size_t *map_sizep)
+{
+	struct stat st;
+	off_t pos;
+	char *buf = NULL, *new;
+	size_t size = 0, cap = 0;
+	ssize_t r;
+	int saved_errno;
+
+	*map_sizep = 0;
+	if (!fstat(fd, &st) && S_ISREG(st.st_mode) && (pos = lseek(fd, 0, SEEK_CUR)) >= 0 && pos < st.st_size) {
+		*basep = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (*basep != MAP_FAILED) {
+			madvise(*basep, (size_t)st.st_size, MADV_SEQUENTIAL);
+			*map_sizep = (size_t)st.st_size;
+			*sizep = (size_t)(st.st_size - pos);
+			return &((const char *)*basep)[pos];
+		}
+	}
+
+	for (;;) {
+		if (size == cap) {
+			cap = cap ? cap * 2 : 1 << 16;
+			if (!(new = realloc(buf, cap)))
+				goto fail;
+			buf = new;
+		}
+		r = read(fd, &buf[size], cap - size);
+		if (r < 0) {
+			if (errno == EINTR)
+				continue;
+			goto fail;
+		}
+		if (!r)
+			break;
+		size += (size_t)r;
+	}
+
+	*basep = buf;
+	*sizep = size;
+	return buf ? buf : "";
+
+fail:
+	saved_errno = errno;
+	free(buf);
+	errno = saved_errno;
+	return NULL;
+}
+
+
+int
+matrix_read_text(Matrix *this, size_t n, size_t m, int fd, size_t nthreads)
+{
+	const char *text, *p, *split, *end;
+	void *base;
+	size_t size, map_size, i, started, total = n * m;
+	TextChunk *chunks = NULL;
+	pthread_t *threads = NULL;
+	int error = 0;
+
+	this->rows = NULL;
+	if (!(text = read_all(fd, &size, &base, &map_size)))
+		return -1;
+	end = &text[size];
+
+	/* Small inputs are not worth a thread each */
+	if (!nthreads)
+		nthreads = 1;
+	if (nthreads > size / (1 << 20) + 1)
+		nthreads = size / (1 << 20) + 1;
+
+	if (matrix_alloc(this, n, m) ||
+	    !(chunks = calloc(nthreads, sizeof(*chunks))) ||
+	    !(threads = calloc(nthreads, sizeof(*threads)))) {
+		error = errno;
+		goto out;
+	}
+
+	/* Split at line breaks, or at any space if a line is too long */
+	for (p = text, i = 0; i < nthreads; i++) {
+		chunks[i].begin = p;
+		split = i + 1 == nthreads ? end : &text[size / nthreads * (i + 1)];
+		if (split < chunks[i].begin)
+			split = chunks[i].begin;
+		for (p = split; p != end && *p != '\n'; p++)
+			if (p - split >= (1 << 16) && IS_SPACE(*p))
+				break;
+		chunks[i].end = p;
+		chunks[i].cells = this->data;
+		chunks[i].total = total;
+	}
+
+	/* Count the integers in each chunk, to know where its first
+	 * integer goes, and then parse the chunks in parallel */
+	for (started = 1; started < nthreads; started++)
+		if (pthread_create(&threads[started], NULL, text_count, &chunks[started]))
+			break;
+	text_count(&chunks[0]);
+	for (i = 1; i < started; i++)
+		pthread_join(threads[i], NULL);
+	for (; i < nthreads; i++)
+		text_count(&chunks[i]);
+
+	for (i = 1; i < nthreads; i++)
+		chunks[i].offset = chunks[i - 1].offset + chunks[i - 1].count;
+	if (chunks[nthreads - 1].offset + chunks[nthreads - 1].count < total) {
+		error = EINVAL;
+		goto out;
+	}
+
+	for (started = 1; started < nthreads; started++)
+		if (pthread_create(&threads[started], NULL, text_parse, &chunks[started]))
+			break;
+	text_parse(&chunks[0]);
+	for (i = 1; i < started; i++)
+		pthread_join(threads[i], NULL);
+	for (; i < nthreads; i++)
+		text_parse(&chunks[i]);
+
+	for (i = 0; i < nthreads && !error; i++)
+		error = chunks[i].error;
+
+out:
+	if (map_size)
+		munmap(base, map_size);
+	else
+		free(base);
+	free(chunks);
+	free(threads);
+	if (error) {
+		if (this->rows)
+			matrix_destroy(this);
+		errno = error;
+		return -1;
+	}
+	return 0;
+}
+
+
+int
+matrix_parse_header(MatrixHeader *this, const unsigned char *header)
+{
+	static const size_t sizes[] = {
+		[MATRIX_INT8]  = 1, [MATRIX_INT16]  = 2, [MATRIX_INT32]  = 4, [MATRIX_INT64] = 8,
+		[MATRIX_UINT8] = 1, [MATRIX_UINT16] = 2, [MATRIX_UINT32] = 4
+	};
+	uint64_t n, m, type, stride, offset;
+
+	n      = get_le(&header[8], 8);
+	m      = get_le(&header[16], 8);
+	type   = get_le(&header[24], 4);
+	stride = get_le(&header[32], 8);
+	offset = get_le(&header[40], 8);
+
+	if (memcmp(header, MATRIX_MAGIC, 8) || !type || type > MATRIX_UINT32 ||
+	    offset < MATRIX_HEADER_SIZE || offset > SIZE_MAX || stride > SIZE_MAX ||
+	    n > SIZE_MAX / sizeof(Cell *) || m > SIZE_MAX / sizes[type] ||
+	    (n && stride < m * sizes[type])) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	this->n = (size_t)n;
+	this->m = (size_t)m;
+	this->type = (int)type;
+	this->element_size = sizes[type];
+	this->row_size = (size_t)m * sizes[type];
+	this->stride = (size_t)stride;
+	this->offset = (size_t)offset;
+	return 0;
+}
+
+
+void
+matrix_decode_row(const MatrixHeader *this, Cell *row, const unsigned char *cells)
+{
+	size_t j, size = this->element_size;
+	uint64_t value;
+
+	for (j = 0; j < this->m; j++, cells += size) {
+		value = get_le(cells, size);
+		if (this->type <= MATRIX_INT64 && size < 8 && (value >> (size * 8 - 1)))
+			value |= UINT64_MAX << (size * 8);
+		row[j] = (Cell)value;
+	}
+}
+
+
+/**
+ * Parses the header of a mapped binary matrix file
+ * and checks that its rows are within the file
+ *
+ * @param   this  Output parameter for the header
+ * @param   base  The mapping of the file
+ * @param   size  The size of the file, at least `MATRIX_HEADER_SIZE`
+ * @return        0 on success, -1 on error
+ */
+static int
+parse_layout(MatrixHeader *this, const unsigned char *base, size_t size)
+{
+	size_t n, avail;
+
+	if (matrix_parse_header(this, base))
+		return -1;
+	n = this->n;
+	if (this->offset > size)
+		goto invalid;
+	avail = size - this->offset;
+	if (n && (this->row_size > avail || (n - 1 && this->stride > (avail - this->row_size) / (n - 1))))
+		goto invalid;
+	return 0;
+
+invalid:
+	errno = EINVAL;
+	return -1;
+}
+
+
+/**
+ * Checks whether the rows of a binary matrix file
+ * can be used as cells without conversion
+ *
+ * @param   this  The file's header
+ * @return        1 if so, 0 otherwise
+ */
+static int
+in_place(const MatrixHeader *this)
+{
+	return this->type == MATRIX_INT64 && native_int64() && !(this->offset % 8) && !(this->stride % 8);
+}
+
+
+int
+matrix_map(Matrix *this, const char *path)
+{
+	int fd, r, saved_errno;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return -1;
+	r = matrix_map_fd(this, fd);
+	saved_errno = errno;
+	close(fd);
+	errno = saved_errno;
+	return r;
+}
+
+
+int
+matrix_map_fd(Matrix *this, int fd)
+{
+	const unsigned char *base;
+	MatrixHeader header;
+	size_t size, n, i;
+	struct stat st;
+	void *map;
+
+	if (fstat(fd, &st))
+		return -1;
+	size = (size_t)st.st_size;
+	if (size < MATRIX_HEADER_SIZE) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Private, so that the solver can use the file as its table */
+	map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	if (map == MAP_FAILED)
+		return -1;
+	base = map;
+
+	if (parse_layout(&header, base, size))
+		goto invalid;
+	n = header.n;
+
+	if (in_place(&header)) {
+		this->rows = malloc((n + !n) * sizeof(Cell *));
+		if (!this->rows) {
+			munmap(map, size);
+			return -1;
+		}
+		this->n = n;
+		this->m = header.m;
+		this->data = map;
+		this->map_size = size;
+		this->allocator = NULL;
+		this->data_size = 0;
+		for (i = 0; i < n; i++)
+			this->rows[i] = (Cell *)(void *)&base[header.offset + i * header.stride];
+		return 0;
+	}
+
+	if (matrix_alloc(this, n, header.m)) {
+		munmap(map, size);
+		return -1;
+	}
+	for (i = 0; i < n; i++)
+		matrix_decode_row(&header, this->rows[i], &base[header.offset + i * header.stride]);
+	munmap(map, size);
+	return 0;
+
+invalid:
+	munmap(map, size);
+	errno = EINVAL;
+	return -1;
+}
+
+
+int
+matrix_rows_open(MatrixRows *this, const char *path)
+{
+	struct stat st;
+	void *map;
+	int fd, saved_errno;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return -1;
+	if (fstat(fd, &st))
+		goto fail;
+	if ((size_t)st.st_size < MATRIX_HEADER_SIZE) {
+		errno = EINVAL;
+		goto fail;
+	}
+	map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (map == MAP_FAILED)
+		goto fail;
+	close(fd);
+
+	this->map = map;
+	this->map_size = (size_t)st.st_size;
+	this->bytes_read = 0;
+	if (parse_layout(&this->header, this->map, this->map_size)) {
+		munmap(map, this->map_size);
+		return -1;
+	}
+	this->in_place = in_place(&this->header);
+	madvise(map, this->map_size, MADV_SEQUENTIAL);
+	return 0;
+
+fail:
+	saved_errno = errno;
+	close(fd);
+	errno = saved_errno;
+	return -1;
+}
+
+
+const Cell *
+matrix_rows_fetch(void *data, size_t row, Cell *buf)
+{
+	MatrixRows *this = data;
+	const unsigned char *cells = &this->map[this->header.offset + row * this->header.stride];
+
+	this->bytes_read += this->header.row_size;
+	if (this->in_place)
+		return (const Cell *)(const void *)cells;
+	matrix_decode_row(&this->header, buf, cells);
+	return buf;
+}
+
+
+void
+matrix_rows_close(MatrixRows *this)
+{
+	munmap((void *)this->map, this->map_size);
+	this->map = NULL;
+}
+
+
+int
+matrix_write(const Matrix *this, const char *path)
+{
+	FILE *fp;
+	int saved_errno;
+
+	fp = fopen(path, "wb");
+	if (!fp)
+		return -1;
+	if (matrix_write_fp(this, fp)) {
+		saved_errno = errno;
+		fclose(fp);
+		errno = saved_errno;
+		return -1;
+	}
+	return fclose(fp) ? -1 : 0;
+}
+
+
+int
+matrix_write_fp(const Matrix *this, FILE *fp)
+{
+	unsigned char header[MATRIX_HEADER_SIZE] = {0}, *row;
+	size_t i, j;
+	int saved_errno;
+
+	row = malloc(this->m * 8 + 1);
+	if (!row)
+		return -1;
+
+	memcpy(header, MATRIX_MAGIC, 8);
+	put_le(&header[8], this->n, 8);
+	put_le(&header[16], this->m, 8);
+	put_le(&header[24], MATRIX_INT64, 4);
+	put_le(&header[32], this->m * 8, 8);
+	put_le(&header[40], MATRIX_HEADER_SIZE, 8);
+	if (fwrite(header, sizeof(header), 1, fp) != 1)
+		goto fail;
+
+	for (i = 0; i < this->n; i++) {
+		for (j = 0; j < this->m; j++)
+			put_le(&row[j * 8], (uint64_t)this->rows[i][j], 8);
+		if (this->m && fwrite(row, this->m * 8, 1, fp) != 1)
+			goto fail;
+	}
+
+	free(row);
+	return fflush(fp) ? -1 : 0;
+
+fail:
+	saved_errno = errno;
+	free(row);
+	errno = saved_errno;
+	return -1;
+}
+
+
+int
+assignment_write_text(FILE *fp, const KuhnIndex *col_of_row, size_t n, Cell cost)
+{
+	size_t i;
+
+	fprintf(fp, "%li\n", cost);
+	for (i = 0; i < n; i++)
+		fprintf(fp, "%zu %zu\n", i, (size_t)col_of_row[i]);
+
+	return (fflush(fp) || ferror(fp)) ? -1 : 0;
+}
+
+
+int
+assignment_write_binary(FILE *fp, const KuhnIndex *col_of_row, size_t n, Cell cost)
+{
+	unsigned char buf[4096];
+	size_t i, len;
+
+	memcpy(buf, ASSIGNMENT_MAGIC, 8);
+	put_le(&buf[8], n, 8);
+	put_le(&buf[16], (uint64_t)cost, 8);
+	len = 24;
+
+	for (i = 0; i < n; i++) {
+		if (len + 16 > sizeof(buf)) {
+			if (fwrite(buf, len, 1, fp) != 1)
+				return -1;
+			len = 0;
+		}
+		put_le(&buf[len], i, 8);
+		put_le(&buf[len + 8], col_of_row[i], 8);
+		len += 16;
+	}
+
+	if (fwrite(buf, len, 1, fp) != 1)
+		return -1;
+	return fflush(fp) ? -1 : 0;
+}
+
+
+int
+matrix_copy(Matrix *this, const Matrix *src)
+{
+	size_t i;
+
+	if (matrix_alloc(this, src->n, src->m))
+		return -1;
+	for (i = 0; i < src->n; i++)
+		memcpy(this->rows[i], src->rows[i], src->m * sizeof(Cell));
+	return 0;
+}
+
+
+void
+matrix_destroy(Matrix *this)
+{
+	if (this->map_size)
+		munmap(this->data, this->map_size);
+	else
+		free_data(this);
+	free(this->rows);
+	this->rows = NULL;
+	this->data = NULL;
+}
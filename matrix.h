@@ -0,0 +1,354 @@
+/**
+ * 𝓞(n³) implementation of the Hungarian algorithm
+ * 
+ * Copyright (C) 2011, 2014, 2020  Mattias Andrée
+ * 
+ * This program is free software. It comes without any warranty, to
+ * the extent permitted by applicable law. You can redistribute it
+ * and/or modify it under the terms of the Do What The Fuck You Want
+ * To Public License, Version 2, as published by Sam Hocevar. See
+ * http://sam.zoy.org/wtfpl/COPYING for more details.
+ */
+
+
+#ifndef MATRIX_H
+#define MATRIX_H
+
+
+#include "hungarian.h"
+
+#include <stdio.h>
+
+
+
+/**
+ * The magic number at the beginning of binary matrix files
+ */
+#define MATRIX_MAGIC  "HUNGMAT1"
+
+/**
+ * The size of the header of binary matrix files
+ */
+#define MATRIX_HEADER_SIZE  64
+
+/**
+ * The magic number at the beginning of binary assignment files
+ */
+#define ASSIGNMENT_MAGIC  "HUNGASG1"
+
+/**
+ * Element types in binary matrix files
+ */
+enum {
+	MATRIX_INT8 = 1,
+	MATRIX_INT16,
+	MATRIX_INT32,
+	MATRIX_INT64,
+	MATRIX_UINT8,
+	MATRIX_UINT16,
+	MATRIX_UINT32
+};
+
+
+/**
+ * Test for the whitespace that separates integers in text matrices
+ */
+#define IS_SPACE(c)  ((c) == ' ' || ((c) >= '\t' && (c) <= '\r'))
+
+
+/**
+ * The header of a binary matrix file, see `matrix_map`
+ */
+typedef struct {
+	size_t n;            /* The height of the table */
+	size_t m;            /* The width of the table */
+	int type;            /* The element type */
+	size_t element_size; /* The number of bytes per cell */
+	size_t row_size;     /* The number of bytes per row, excluding padding */
+	size_t stride;       /* The number of bytes from one row to the next */
+	size_t offset;       /* The offset of the first row */
+} MatrixHeader;
+
+
+/**
+ * A table of costs loaded by the command line program
+ */
+typedef struct {
+	/**
+	 * The height of the table
+	 */
+	size_t n;
+
+	/**
+	 * The width of the table
+	 */
+	size_t m;
+
+	/**
+	 * The rows of the table
+	 */
+	Cell **rows;
+
+	/**
+	 * The memory the rows point into
+	 */
+	void *data;
+
+	/**
+	 * The size of `data` if it is a file mapping, 0 if it is allocated
+	 */
+	size_t map_size;
+
+	/**
+	 * The allocator `data` was allocated with, `NULL` for malloc(3)
+	 */
+	const KuhnAllocator *allocator;
+
+	/**
+	 * The number of bytes allocated for `data` with `allocator`
+	 */
+	size_t data_size;
+} Matrix;
+
+
+/**
+ * A binary matrix file that is read one row at a time,
+ * see `matrix_rows_open`
+ */
+typedef struct {
+	/**
+	 * The file's header
+	 */
+	MatrixHeader header;
+
+	/**
+	 * The mapping of the file
+	 */
+	const unsigned char *map;
+
+	/**
+	 * The size of `map`
+	 */
+	size_t map_size;
+
+	/**
+	 * Whether the rows can be used in place
+	 */
+	int in_place;
+
+	/**
+	 * The number of bytes of rows fetched so far
+	 */
+	uint64_t bytes_read;
+} MatrixRows;
+
+
+
+/**
+ * Generates a table with random costs in [0, 63]
+ *
+ * @param   this  Output parameter for the table
+ * @param   n     The height of the table
+ * @param   m     The width of the table
+ * @return        0 on success, -1 on error
+ */
+int matrix_random(Matrix *this, size_t n, size_t m);
+
+/**
+ * Reads a table of whitespace-separated integers, integers
+ * beyond the first `n * m` are ignored
+ *
+ * The input is mapped if it is a regular file, and otherwise
+ * read into memory, and is then split at line breaks and
+ * parsed in parallel
+ *
+ * @param   this      Output parameter for the table
+ * @param   n         The height of the table
+ * @param   m         The width of the table
+ * @param   fd        The file to read, from its current offset
+ * @param   nthreads  The number of threads to use
+ * @return            0 on success, -1 on error
+ */
+int matrix_read_text(Matrix *this, size_t n, size_t m, int fd, size_t nthreads);
+
+/**
+ * Parses an integer in a text matrix
+ *
+ * @param   p      The beginning of the integer
+ * @param   end    The end of the text
+ * @param   cellp  Output parameter for the integer
+ * @return         The end of the integer, `NULL` on error
+ */
+const char *matrix_parse_cell(const char *p, const char *end, Cell *cellp);
+
+/**
+ * Parses and checks the header of a binary matrix file
+ *
+ * @param   this    Output parameter for the header
+ * @param   header  The first `MATRIX_HEADER_SIZE` bytes of the file
+ * @return          0 on success, -1 on error
+ */
+int matrix_parse_header(MatrixHeader *this, const unsigned char *header);
+
+/**
+ * Converts a row of a binary matrix file to cells
+ *
+ * @param  this   The file's header
+ * @param  row    Output array for the cells
+ * @param  cells  The row in the file
+ */
+void matrix_decode_row(const MatrixHeader *this, Cell *row, const unsigned char *cells);
+
+/**
+ * Maps a binary matrix file into memory
+ *
+ * The file starts with a 64-byte little-endian header:
+ * the magic number `MATRIX_MAGIC` (8 bytes), the height
+ * and width (8 bytes each), the element type (4 bytes,
+ * `MATRIX_INT8` to `MATRIX_UINT32`), 4 reserved bytes,
+ * the number of bytes from the beginning of one row to
+ * the beginning of the next (8 bytes), and the offset of
+ * the first row from the beginning of the file (8 bytes),
+ * followed by zeroes. The cells are stored little-endian.
+ *
+ * If the cells are `MATRIX_INT64` and suitably aligned, and
+ * the host is little-endian, the rows point directly into a
+ * private mapping of the file, so loading it only costs page
+ * faults, and writes to the table are not written to the file;
+ * otherwise the cells are converted into allocated memory
+ *
+ * @param   this  Output parameter for the table
+ * @param   path  The file to map
+ * @return        0 on success, -1 on error
+ */
+int matrix_map(Matrix *this, const char *path);
+
+/**
+ * Like `matrix_map`, but maps an open file
+ *
+ * @param   this  Output parameter for the table
+ * @param   fd    The file to map, it is not closed
+ * @return        0 on success, -1 on error
+ */
+int matrix_map_fd(Matrix *this, int fd);
+
+/**
+ * Opens a binary matrix file, see `matrix_map`, to be read
+ * one row at a time with `matrix_rows_fetch`, for tables that
+ * should not be loaded into memory
+ *
+ * The file is mapped read-only and only advised to be read
+ * sequentially, so its pages can be dropped under memory
+ * pressure and are only read when their rows are fetched
+ *
+ * @param   this  Output parameter for the file
+ * @param   path  The file to open
+ * @return        0 on success, -1 on error
+ */
+int matrix_rows_open(MatrixRows *this, const char *path);
+
+/**
+ * Fetches a row of a file opened with `matrix_rows_open`,
+ * usable as a `KuhnRowFunction`
+ *
+ * @param   data  The `MatrixRows`
+ * @param   row   The index of the row
+ * @param   buf   Buffer for the row, used unless the file's
+ *                cells can be used in place
+ * @return        The row's cells
+ */
+const Cell *matrix_rows_fetch(void *data, size_t row, Cell *buf);
+
+/**
+ * Closes a file opened with `matrix_rows_open`
+ *
+ * @param  this  The file
+ */
+void matrix_rows_close(MatrixRows *this);
+
+/**
+ * Writes a table as a binary matrix file with
+ * `MATRIX_INT64` cells, see `matrix_map`
+ *
+ * @param   this  The table
+ * @param   path  The file to write
+ * @return        0 on success, -1 on error
+ */
+int matrix_write(const Matrix *this, const char *path);
+
+/**
+ * Like `matrix_write`, but writes to an open file
+ *
+ * @param   this  The table
+ * @param   fp    The file to write, it is flushed but not closed
+ * @return        0 on success, -1 on error
+ */
+int matrix_write_fp(const Matrix *this, FILE *fp);
+
+/**
+ * Writes an assignment as text: the total cost on the
+ * first line, followed by one line per row with the
+ * row's index and its column's index
+ *
+ * @param   fp          The file to write
+ * @param   col_of_row  The assignment, the column assigned to each row
+ * @param   n           The number of rows
+ * @param   cost        The total cost
+ * @return              0 on success, -1 on error
+ */
+int assignment_write_text(FILE *fp, const KuhnIndex *col_of_row, size_t n, Cell cost);
+
+/**
+ * Writes an assignment in binary: the magic number
+ * `ASSIGNMENT_MAGIC`, the number of rows, and the total
+ * cost, followed by the row's index and its column's
+ * index for each row, all as little-endian 64-bit integers
+ *
+ * @param   fp          The file to write
+ * @param   col_of_row  The assignment, the column assigned to each row
+ * @param   n           The number of rows
+ * @param   cost        The total cost
+ * @return              0 on success, -1 on error
+ */
+int assignment_write_binary(FILE *fp, const KuhnIndex *col_of_row, size_t n, Cell cost);
+
+/**
+ * Changes the size of an allocated table, reusing its memory,
+ * the contents of the table are unspecified afterwards
+ *
+ * @param   this  The table, zero-initialise it to allocate a new table
+ * @param   n     The new height of the table
+ * @param   m     The new width of the table
+ * @return        0 on success, -1 on error, in which
+ *                case the table must still be destroyed
+ */
+int matrix_resize(Matrix *this, size_t n, size_t m);
+
+/**
+ * Sets the allocator that the cells of tables are allocated
+ * with from now on, for example `kuhn_page_allocator` to
+ * place them with huge pages or across NUMA nodes; tables
+ * that are mapped from a file in place are not affected
+ *
+ * @param  allocator  The allocator, `NULL` for malloc(3)
+ */
+void matrix_set_allocator(const KuhnAllocator *allocator);
+
+/**
+ * Copies a table into allocated memory
+ *
+ * @param   this  Output parameter for the copy
+ * @param   src   The table to copy
+ * @return        0 on success, -1 on error
+ */
+int matrix_copy(Matrix *this, const Matrix *src);
+
+/**
+ * Deallocates or unmaps a table
+ *
+ * @param  this  The table
+ */
+void matrix_destroy(Matrix *this);
+
+
+#endif
@@ -0,0 +1,930 @@
+/**
+ * 𝓞(n³) implementation of the Hungarian algorithm
+ * 
+ * Copyright (C) 2011, 2014, 2020  Mattias Andrée
+ * 
+ * This program is free software. It comes without any warranty, to
+ * the extent permitted by applicable law. You can redistribute it
+ * and/or modify it under the terms of the Do What The Fuck You Want
+ * To Public License, Version 2, as published by Sam Hocevar. See
+ * http://sam.zoy.org/wtfpl/COPYING for more details.
+ */
+
+
+#include "common.h"
+
+#include <pthread.h>
+#include <unistd.h>
+
+
+/*
+ * The table is padded to a square with zero-cost phantom rows
+ * and the solution space is only partitioned on the real rows.
+ * A subproblem fixes the rows [0, fixed) to the columns they
+ * have in the subproblem's solution, and forbids a set of
+ * columns in the row `fixed`. When a subproblem is partitioned,
+ * its t:th child fixes another t rows and forbids the column
+ * the next row has in the parent's solution; forbidden cells
+ * in rows that become fixed are satisfied by the fixation, so
+ * only the forbidden cells in the first non-fixed row are kept.
+ * 
+ * The parent's potentials remain feasible for the child, since
+ * fixed rows and their columns are simply left out and forbidding
+ * a cell only raises its cost, so the child is solved by
+ * unassigning the row with the new forbidden cell and running
+ * one shortest augmenting path search.
+ * 
+ * Children are not solved when they are created. Instead they are
+ * queued with a lower bound, the parent's cost plus the smallest
+ * reduced costs the row and the column of the forbidden cell can
+ * be reassigned with, and are only solved once they reach the
+ * front of the queue. Most children never get there.
+ */
+
+
+/**
+ * The solution of a subproblem, shared by its children
+ */
+typedef struct {
+	/**
+	 * The number of subproblems that refer to the solution
+	 */
+	size_t refs;
+
+	/**
+	 * The column assigned to each row
+	 */
+	ssize_t *row_col;
+
+	/**
+	 * Row potentials
+	 */
+	Cell *u;
+
+	/**
+	 * Column potentials
+	 */
+	Cell *v;
+
+	char _buf[];
+} MurtyState;
+
+
+/**
+ * A subproblem
+ */
+typedef struct {
+	/**
+	 * The cost of the subproblem's solution if it has been
+	 * solved, otherwise a lower bound of the cost
+	 */
+	Cell cost;
+
+	/**
+	 * Whether the subproblem has been solved
+	 */
+	Boolean solved;
+
+	/**
+	 * The number of leading rows that are fixed
+	 */
+	size_t fixed;
+
+	/**
+	 * The subproblem's solution if it has been
+	 * solved, otherwise its parent's solution
+	 */
+	MurtyState *state;
+
+	/**
+	 * The number of forbidden columns in the row `fixed`
+	 */
+	size_t nforbidden;
+
+	/**
+	 * The forbidden columns in the row `fixed`
+	 */
+	size_t forbidden[];
+} MurtyNode;
+
+
+/**
+ * The problem being solved
+ */
+typedef struct {
+	/**
+	 * The number of real rows
+	 */
+	size_t n;
+
+	/**
+	 * The number of rows and columns after padding
+	 */
+	size_t k;
+
+	/**
+	 * The table
+	 */
+	Cell *const *table;
+
+	/**
+	 * `k` zeroes, the cost of phantom rows
+	 */
+	Cell *zeroes;
+
+	/**
+	 * Whether the costs are negated, so that the
+	 * assignments with the highest total are found
+	 */
+	Boolean maximize;
+} Murty;
+
+
+/**
+ * Per-thread state for solving subproblems
+ */
+typedef struct {
+	/**
+	 * The problem
+	 */
+	const Murty *problem;
+
+	/**
+	 * The subproblem being solved, `NULL` for the full problem
+	 */
+	const MurtyNode *node;
+
+	/**
+	 * Scratch memory for `sap_augment`
+	 */
+	SapScratch scratch;
+
+	/**
+	 * The row assigned to each column
+	 */
+	ssize_t *col_row;
+
+	/**
+	 * The columns that are not fixed
+	 */
+	size_t *cols;
+
+	/**
+	 * Whether each column is fixed
+	 */
+	Boolean *fixed;
+} MurtyWorker;
+
+
+/**
+ * Subproblems that are solved in parallel
+ */
+typedef struct {
+	/**
+	 * The subproblems
+	 */
+	MurtyNode **nodes;
+
+	/**
+	 * Output array for the solution of each subproblem,
+	 * `NULL` for infeasible subproblems
+	 */
+	MurtyState **states;
+
+	/**
+	 * The number of subproblems
+	 */
+	size_t count;
+
+	/**
+	 * The number of threads
+	 */
+	size_t nthreads;
+
+	/**
+	 * The number of threads working on the job, at most
+	 * `nthreads` and at most one per subproblem
+	 */
+	size_t active;
+
+	/**
+	 * Set on allocation failure
+	 */
+	volatile Boolean failed;
+
+	/**
+	 * Trace to write the workers to, may be `NULL`
+	 */
+	KuhnTrace *trace;
+
+	/**
+	 * Whether `murty_start` has been called
+	 */
+	Boolean launched;
+
+	/**
+	 * The number of threads that are running, including
+	 * the calling thread, at most `nthreads`
+	 */
+	size_t started;
+
+	/**
+	 * Protects `batch`, `busy`, and `exit`
+	 */
+	pthread_mutex_t lock;
+
+	/**
+	 * Broadcast when a batch is handed out, when
+	 * it is finished, and when the threads shall exit
+	 */
+	pthread_cond_t cond;
+
+	/**
+	 * The number of batches handed out to the threads
+	 */
+	size_t batch;
+
+	/**
+	 * The number of started threads, other than
+	 * the calling thread, still working on the batch
+	 */
+	size_t busy;
+
+	/**
+	 * Whether the threads shall exit
+	 */
+	Boolean exit;
+} MurtyJob;
+
+
+/**
+ * Argument for `murty_thread`
+ */
+typedef struct {
+	MurtyJob *job;
+	MurtyWorker *worker;
+	size_t index;
+} MurtyThread;
+
+
+/**
+ * Allocates a solution
+ * 
+ * @param   k  The number of rows and columns
+ * @return     The solution, `NULL` on error
+ */
+static MurtyState *
+murty_state_create(size_t k)
+{
+	MurtyState *this = malloc(offsetof(MurtyState, _buf) + 2 * k * sizeof(Cell) + k * sizeof(ssize_t));
+	if (!this)
+		return NULL;
+
+	this->refs    = 1;
+	this->u       = (Cell *)&this->_buf[0];
+	this->v       = (Cell *)&this->_buf[k * sizeof(Cell)];
+	this->row_col = (ssize_t *)&this->_buf[2 * k * sizeof(Cell)];
+
+	return this;
+}
+
+
+/**
+ * Releases a reference to a solution
+ * 
+ * @param  this  The solution
+ */
+static void
+murty_state_release(MurtyState *this)
+{
+	if (!--this->refs)
+		free(this);
+}
+
+
+/**
+ * Deallocates a subproblem
+ * 
+ * @param  this  The subproblem
+ */
+static void
+murty_node_destroy(MurtyNode *this)
+{
+	murty_state_release(this->state);
+	free(this);
+}
+
+
+/**
+ * Gets the cost of a cell in one of the real rows,
+ * negated if the assignments are maximised
+ * 
+ * @param   problem  The problem
+ * @param   row      The row
+ * @param   col      The column
+ * @return           The cost
+ */
+static Cell
+murty_cost(const Murty *problem, size_t row, size_t col)
+{
+	return problem->maximize ? -problem->table[row][col] : problem->table[row][col];
+}
+
+
+/**
+ * Row fetcher for `sap_augment`
+ */
+static const Cell *
+murty_get_row(void *ctx, size_t row, Cell *buf)
+{
+	MurtyWorker *this = ctx;
+	const Murty *problem = this->problem;
+	size_t i;
+
+	if (row >= problem->n)
+		return problem->zeroes;
+	if (problem->maximize) {
+		for (i = 0; i < problem->k; i++)
+			buf[i] = -problem->table[row][i];
+	} else if (!this->node || row != this->node->fixed) {
+		return problem->table[row];
+	} else {
+		memcpy(buf, problem->table[row], problem->k * sizeof(Cell));
+	}
+	if (!this->node || row != this->node->fixed)
+		return buf;
+
+	for (i = 0; i < this->node->nforbidden; i++)
+		buf[this->node->forbidden[i]] = FORBIDDEN;
+	return buf;
+}
+
+
+/**
+ * Allocates the scratch memory of a worker
+ * 
+ * @param   this     The worker
+ * @param   problem  The problem
+ * @return           0 on success, -1 on error
+ */
+static int
+murty_worker_init(MurtyWorker *this, const Murty *problem)
+{
+	size_t k = problem->k + !problem->k;
+
+	this->problem      = problem;
+	this->node         = NULL;
+	this->scratch.minv = malloc(k * sizeof(*this->scratch.minv));
+	this->scratch.way  = malloc(k * sizeof(*this->scratch.way));
+	this->scratch.todo = malloc(k * sizeof(*this->scratch.todo));
+	this->scratch.buf  = malloc(k * sizeof(*this->scratch.buf));
+	this->col_row      = malloc(k * sizeof(*this->col_row));
+	this->cols         = malloc(k * sizeof(*this->cols));
+	this->fixed        = malloc(k * sizeof(*this->fixed));
+
+	if (!this->scratch.minv || !this->scratch.way || !this->scratch.todo ||
+	    !this->scratch.buf || !this->col_row || !this->cols || !this->fixed)
+		return -1;
+	return 0;
+}
+
+
+/**
+ * Deallocates the scratch memory of a worker
+ * 
+ * @param  this  The worker
+ */
+static void
+murty_worker_destroy(MurtyWorker *this)
+{
+	free(this->scratch.minv);
+	free(this->scratch.way);
+	free(this->scratch.todo);
+	free(this->scratch.buf);
+	free(this->col_row);
+	free(this->cols);
+	free(this->fixed);
+}
+
+
+/**
+ * Solves a subproblem with one augmentation from its parent's solution
+ * 
+ * @param   this    The worker
+ * @param   node    The subproblem, the row `node->fixed` must be assigned
+ *                  to one of the forbidden columns in the parent's solution
+ * @param   statep  Output parameter for the solution, `NULL` if infeasible
+ * @param   costp   Output parameter for the cost of the solution
+ * @return          0 on success, -1 on error
+ */
+static int
+murty_solve(MurtyWorker *this, const MurtyNode *node, MurtyState **statep, Cell *costp)
+{
+	const Murty *problem = this->problem;
+	size_t i, j, k = problem->k, ncols = 0, row = node->fixed;
+	MurtyState *state;
+	Cell cost = 0;
+
+	*statep = NULL;
+	if (!(state = murty_state_create(k)))
+		return -1;
+	memcpy(state->u, node->state->u, k * sizeof(Cell));
+	memcpy(state->v, node->state->v, k * sizeof(Cell));
+	memcpy(state->row_col, node->state->row_col, k * sizeof(ssize_t));
+
+	memset(this->fixed, 0, k * sizeof(*this->fixed));
+	for (i = 0; i < row; i++)
+		this->fixed[state->row_col[i]] = 1;
+	for (j = 0; j < k; j++)
+		if (!this->fixed[j])
+			this->cols[ncols++] = j;
+	for (i = 0; i < k; i++)
+		this->col_row[state->row_col[i]] = (ssize_t)i;
+	this->col_row[state->row_col[row]] = -1;
+	state->row_col[row] = -1;
+
+	this->node = node;
+	if (sap_augment(row, ncols, this->cols, state->u, state->v, state->row_col,
+	                this->col_row, &this->scratch, murty_get_row, this)) {
+		free(state);
+		return 0;
+	}
+
+	for (i = 0; i < problem->n; i++)
+		cost += murty_cost(problem, i, (size_t)state->row_col[i]);
+	*statep = state;
+	*costp = cost;
+	return 0;
+}
+
+
+/**
+ * Solves every `job->active`:th subproblem
+ * in a job starting with the subproblem `index`
+ * 
+ * @param  this  The thread's argument
+ */
+static void
+murty_work(MurtyThread *this)
+{
+	MurtyJob *job = this->job;
+	uint_fast64_t start = job->trace ? kuhn_now() : 0, solve_start;
+	size_t t;
+
+	for (t = this->index; t < job->count && !job->failed; t += job->active) {
+		solve_start = job->trace ? kuhn_now() : 0;
+		if (murty_solve(this->worker, job->nodes[t], &job->states[t], &job->nodes[t]->cost))
+			job->failed = 1;
+		if (job->trace)
+			trace_span(job->trace, "murty_solve", solve_start, kuhn_now());
+	}
+
+	if (job->trace && this->index < job->active)
+		trace_span(job->trace, "murty_worker", start, kuhn_now());
+}
+
+
+/**
+ * Works on each batch that is handed out until told to exit
+ */
+static void *
+murty_thread(void *arg)
+{
+	MurtyThread *this = arg;
+	MurtyJob *job = this->job;
+	size_t batch = 0;
+
+	for (;;) {
+		pthread_mutex_lock(&job->lock);
+		while (job->batch == batch && !job->exit)
+			pthread_cond_wait(&job->cond, &job->lock);
+		if (job->exit) {
+			pthread_mutex_unlock(&job->lock);
+			break;
+		}
+		batch = job->batch;
+		pthread_mutex_unlock(&job->lock);
+
+		murty_work(this);
+
+		pthread_mutex_lock(&job->lock);
+		if (!--job->busy)
+			pthread_cond_broadcast(&job->cond);
+		pthread_mutex_unlock(&job->lock);
+	}
+
+	return NULL;
+}
+
+
+/**
+ * Starts the threads, other than the calling thread, that
+ * work on the batches; they are started once and kept until
+ * `murty_stop`, rather than started for every batch
+ * 
+ * @param  job      The job
+ * @param  threads  `job->nthreads` thread arguments
+ * @param  tids     Scratch memory for `job->nthreads` thread IDs
+ */
+static void
+murty_start(MurtyJob *job, MurtyThread *threads, pthread_t *tids)
+{
+	/* If a thread cannot be started, the calling
+	 * thread does its share of every batch */
+	for (job->started = 1; job->started < job->nthreads; job->started++)
+		if (pthread_create(&tids[job->started], NULL, murty_thread, &threads[job->started]))
+			break;
+}
+
+
+/**
+ * Tells the threads started by `murty_start` to exit and joins them
+ * 
+ * @param  job   The job
+ * @param  tids  The thread IDs
+ */
+static void
+murty_stop(MurtyJob *job, pthread_t *tids)
+{
+	size_t i;
+
+	pthread_mutex_lock(&job->lock);
+	job->exit = 1;
+	pthread_cond_broadcast(&job->cond);
+	pthread_mutex_unlock(&job->lock);
+
+	for (i = 1; i < job->started; i++)
+		pthread_join(tids[i], NULL);
+	job->started = 1;
+}
+
+
+/**
+ * Solves subproblems in parallel, the threads are started
+ * with `murty_start` for the first batch that has more than
+ * one subproblem, and are kept for the following batches
+ * 
+ * @param   job      The subproblems, `nodes`, `states`, and `count` must be set
+ * @param   threads  The thread arguments, see `murty_start`
+ * @param   tids     Scratch memory for `job->nthreads` thread IDs
+ * @return           0 on success, -1 on error
+ */
+static int
+murty_solve_parallel(MurtyJob *job, MurtyThread *threads, pthread_t *tids)
+{
+	size_t i;
+	Boolean handed_out;
+
+	/* A single subproblem is solved without waking the threads */
+	job->active = job->count < job->nthreads ? job->count : job->nthreads;
+	job->failed = 0;
+	for (i = 0; i < job->count; i++)
+		job->states[i] = NULL;
+
+	if (job->active > 1 && !job->launched) {
+		murty_start(job, threads, tids);
+		job->launched = 1;
+	}
+
+	handed_out = job->active > 1 && job->started > 1;
+	if (handed_out) {
+		pthread_mutex_lock(&job->lock);
+		job->batch++;
+		job->busy = job->started - 1;
+		pthread_cond_broadcast(&job->cond);
+		pthread_mutex_unlock(&job->lock);
+	}
+
+	murty_work(&threads[0]);
+
+	if (handed_out) {
+		pthread_mutex_lock(&job->lock);
+		while (job->busy)
+			pthread_cond_wait(&job->cond, &job->lock);
+		pthread_mutex_unlock(&job->lock);
+	}
+
+	/* The share of threads that could not be started */
+	for (i = job->started; i < job->active; i++)
+		murty_work(&threads[i]);
+
+	return job->failed ? -1 : 0;
+}
+
+
+/**
+ * Orders subproblems by cost, and solved subproblems first
+ * 
+ * @param   a  One of the subproblems
+ * @param   b  The other subproblem
+ * @return     Whether `a` should be dequeued before `b`
+ */
+#if defined(__GNUC__)
+__attribute__((__pure__))
+#endif
+static int
+murty_before(const MurtyNode *a, const MurtyNode *b)
+{
+	return a->cost != b->cost ? a->cost < b->cost : a->solved > b->solved;
+}
+
+
+/**
+ * Restores the heap property after an element has been appended
+ * 
+ * @param  heap  The heap
+ * @param  i     The index of the appended element
+ */
+static void
+heap_up(MurtyNode **heap, size_t i)
+{
+	MurtyNode *x = heap[i];
+	for (; i && murty_before(x, heap[(i - 1) / 2]); i = (i - 1) / 2)
+		heap[i] = heap[(i - 1) / 2];
+	heap[i] = x;
+}
+
+
+/**
+ * Removes the first element from a heap
+ * 
+ * @param   heap  The heap
+ * @param   size  The number of elements in the heap
+ * @return        The removed element
+ */
+static MurtyNode *
+heap_pop(MurtyNode **heap, size_t size)
+{
+	MurtyNode *ret = heap[0], *x = heap[--size];
+	size_t i = 0, c;
+
+	for (; (c = 2 * i + 1) < size; i = c) {
+		if (c + 1 < size && murty_before(heap[c + 1], heap[c]))
+			c++;
+		if (!murty_before(heap[c], x))
+			break;
+		heap[i] = heap[c];
+	}
+	heap[i] = x;
+
+	return ret;
+}
+
+
+/**
+ * Partitions a solved subproblem into unsolved
+ * children and adds them to the queue
+ * 
+ * @param   problem  The problem
+ * @param   node     The subproblem
+ * @param   heapp    Reference to the queue
+ * @param   sizep    Reference to the number of elements in the queue
+ * @param   capp     Reference to the capacity of the queue
+ * @param   fixed    Scratch memory for `problem->k` columns
+ * @return           0 on success, -1 on error
+ */
+static int
+murty_partition(const Murty *problem, MurtyNode *node, MurtyNode ***heapp,
+                size_t *sizep, size_t *capp, Boolean *fixed)
+{
+	MurtyState *state = node->state;
+	size_t i, j, row, col, nforbidden, k = problem->k;
+	Cell min_row, min_col, reduced, *u = state->u, *v = state->v;
+	MurtyNode *child;
+	void *new;
+
+	memset(fixed, 0, k * sizeof(*fixed));
+	for (i = 0; i < node->fixed; i++)
+		fixed[state->row_col[i]] = 1;
+
+	for (row = node->fixed; row < problem->n; fixed[col] = 1, row++) {
+		col = (size_t)state->row_col[row];
+		nforbidden = row == node->fixed ? node->nforbidden : 0;
+
+		/* Bound the cost of reassigning the row and the column */
+		for (i = 0; i < nforbidden; i++)
+			fixed[node->forbidden[i]] += 2;
+		min_row = min_col = CELL_MAX;
+		for (j = 0; j < k; j++) {
+			if (!fixed[j] && j != col) {
+				reduced = murty_cost(problem, row, j) - u[row] - v[j];
+				if (min_row > reduced)
+					min_row = reduced;
+			}
+		}
+		for (i = 0; i < nforbidden; i++)
+			fixed[node->forbidden[i]] -= 2;
+		for (i = row + 1; i < k; i++) {
+			reduced = (i < problem->n ? murty_cost(problem, i, col) : 0) - u[i] - v[col];
+			if (min_col > reduced)
+				min_col = reduced;
+		}
+		if (min_row == CELL_MAX || min_col == CELL_MAX)
+			continue;
+
+		if (!(child = malloc(offsetof(MurtyNode, forbidden) + (nforbidden + 1) * sizeof(size_t))))
+			return -1;
+		child->cost = node->cost + min_row + min_col;
+		child->solved = 0;
+		child->fixed = row;
+		child->state = state;
+		child->nforbidden = nforbidden + 1;
+		memcpy(child->forbidden, node->forbidden, nforbidden * sizeof(size_t));
+		child->forbidden[nforbidden] = col;
+		state->refs += 1;
+
+		if (*sizep == *capp) {
+			*capp = *capp ? *capp * 2 : 64;
+			if (!(new = realloc(*heapp, *capp * sizeof(**heapp)))) {
+				murty_node_destroy(child);
+				return -1;
+			}
+			*heapp = new;
+		}
+		(*heapp)[*sizep] = child;
+		heap_up(*heapp, (*sizep)++);
+	}
+
+	return 0;
+}
+
+
+ssize_t
+kuhn_kbest(size_t n, size_t m, Cell *const *table, size_t k, const KuhnOptions *options,
+           KuhnIndex *assignments, Cell *costs)
+{
+	size_t i, found = 0, size = 0, cap = 0, batch;
+	size_t nthreads = options && options->threads > 1 ? options->threads : 1;
+	long int cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	KuhnTrace *trace = options ? options->trace : NULL;
+	const struct timespec *deadline = options ? options->deadline : NULL;
+	uint_fast64_t start = trace ? kuhn_now() : 0, phase_start = start;
+	MurtyNode **heap = NULL, *node = NULL, **nodes = NULL;
+	MurtyState **states = NULL;
+	MurtyWorker *workers;
+	MurtyThread *threads = NULL;
+	pthread_t *tids = NULL;
+	MurtyJob job;
+	Murty problem;
+	int saved_errno;
+
+	if (n > m || nthreads > SIZE_MAX / sizeof(MurtyThread) || (options && options->allocator)) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (!k)
+		return 0;
+
+	/* More threads than processors would only add handoffs */
+	if (cpus > 0 && nthreads > (size_t)cpus)
+		nthreads = (size_t)cpus;
+
+	job.nthreads = nthreads;
+	job.trace = trace;
+	job.launched = 0;
+	job.started = 1;
+	job.batch = 0;
+	job.busy = 0;
+	job.exit = 0;
+	pthread_mutex_init(&job.lock, NULL);
+	pthread_cond_init(&job.cond, NULL);
+
+	problem.n = n;
+	problem.k = m;
+	problem.table = table;
+	problem.maximize = options ? options->maximize : 0;
+	problem.zeroes = calloc(m + !m, sizeof(Cell));
+	workers = calloc(nthreads, sizeof(*workers));
+	nodes = malloc(nthreads * sizeof(*nodes));
+	states = malloc(nthreads * sizeof(*states));
+	threads = malloc(nthreads * sizeof(*threads));
+	tids = malloc(nthreads * sizeof(*tids));
+	if (!problem.zeroes || !workers || !nodes || !states || !threads || !tids)
+		goto fail;
+	for (i = 0; i < nthreads; i++)
+		if (murty_worker_init(&workers[i], &problem))
+			goto fail;
+	for (i = 0; i < nthreads; i++) {
+		threads[i].job = &job;
+		threads[i].worker = &workers[i];
+		threads[i].index = i;
+	}
+	job.nodes = nodes;
+	job.states = states;
+
+	/* Solve the full problem */
+	if (!(node = calloc(1, sizeof(*node))))
+		goto fail;
+	if (!(node->state = murty_state_create(m))) {
+		free(node);
+		node = NULL;
+		goto fail;
+	}
+	node->solved = 1;
+	memset(node->state->u, 0, m * sizeof(Cell));
+	memset(node->state->v, 0, m * sizeof(Cell));
+	for (i = 0; i < m; i++) {
+		node->state->row_col[i] = -1;
+		workers->col_row[i] = -1;
+		workers->cols[i] = i;
+	}
+	for (i = 0; i < m; i++)
+		sap_augment(i, m, workers->cols, node->state->u, node->state->v, node->state->row_col,
+		            workers->col_row, &workers->scratch, murty_get_row, workers);
+	for (i = 0; i < n; i++)
+		node->cost += murty_cost(&problem, i, (size_t)node->state->row_col[i]);
+	if (trace)
+		trace_span(trace, "murty_initial_solve", phase_start, kuhn_now());
+
+
+	for (;;) {
+		if (node->solved) {
+			for (i = 0; i < n; i++)
+				assignments[found * n + i] = (KuhnIndex)node->state->row_col[i];
+			costs[found++] = problem.maximize ? -node->cost : node->cost;
+			if (found == k || kuhn_expired(deadline))
+				break;
+			phase_start = trace ? kuhn_now() : 0;
+			if (murty_partition(&problem, node, &heap, &size, &cap, workers->fixed))
+				goto fail;
+			if (trace)
+				trace_span(trace, "murty_partition", phase_start, kuhn_now());
+			murty_node_destroy(node);
+			node = NULL;
+		} else if (kuhn_expired(deadline)) {
+			break;
+		} else {
+			/* Solve the unsolved subproblems at the front of the queue */
+			nodes[0] = node;
+			node = NULL;
+			for (batch = 1; batch < nthreads && size && !heap[0]->solved; batch++)
+				nodes[batch] = heap_pop(heap, size--);
+			job.count = batch;
+			if (murty_solve_parallel(&job, threads, tids)) {
+				for (i = 0; i < batch; i++) {
+					if (states[i])
+						murty_state_release(states[i]);
+					murty_node_destroy(nodes[i]);
+				}
+				goto fail;
+			}
+			for (i = 0; i < batch; i++) {
+				if (!states[i]) {
+					murty_node_destroy(nodes[i]);
+					continue;
+				}
+				murty_state_release(nodes[i]->state);
+				nodes[i]->state = states[i];
+				nodes[i]->solved = 1;
+				heap[size] = nodes[i];
+				heap_up(heap, size++);
+			}
+		}
+
+		if (!size)
+			break;
+		node = heap_pop(heap, size--);
+	}
+
+	murty_stop(&job, tids);
+	pthread_cond_destroy(&job.cond);
+	pthread_mutex_destroy(&job.lock);
+	if (node)
+		murty_node_destroy(node);
+	for (i = 0; i < size; i++)
+		murty_node_destroy(heap[i]);
+	free(heap);
+	free(nodes);
+	free(states);
+	free(threads);
+	free(tids);
+	for (i = 0; i < nthreads; i++)
+		murty_worker_destroy(&workers[i]);
+	free(workers);
+	free(problem.zeroes);
+	if (trace)
+		trace_span(trace, "kuhn_kbest", start, kuhn_now());
+	return (ssize_t)found;
+
+fail:
+	saved_errno = errno;
+	murty_stop(&job, tids);
+	pthread_cond_destroy(&job.cond);
+	pthread_mutex_destroy(&job.lock);
+	if (node)
+		murty_node_destroy(node);
+	for (i = 0; i < size; i++)
+		murty_node_destroy(heap[i]);
+	free(heap);
+	free(nodes);
+	free(states);
+	free(threads);
+	free(tids);
+	if (workers)
+		for (i = 0; i < nthreads; i++)
+			murty_worker_destroy(&workers[i]);
+	free(workers);
+	free(problem.zeroes);
+	errno = saved_errno;
+	return -1;
+}
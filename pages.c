@@ -0,0 +1,208 @@
+/**
+ * 𝓞(n³) implementation of the Hungarian algorithm
+ * 
+ * Copyright (C) 2011, 2014, 2020  Mattias Andrée
+ * 
+ * This program is free software. It comes without any warranty, to
+ * the extent permitted by applicable law. You can redistribute it
+ * and/or modify it under the terms of the Do What The Fuck You Want
+ * To Public License, Version 2, as published by Sam Hocevar. See
+ * http://sam.zoy.org/wtfpl/COPYING for more details.
+ */
+
+
+
+#include "common.h"
+
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <unistd.h>
+#if defined(__linux__)
+# include <sys/syscall.h>
+#endif
+
+
+/**
+ * The size of a huge page, huge page mappings are
+ * aligned to, and a multiple of, this size, and
+ * smaller allocations do not use huge pages
+ */
+#define HUGE_PAGE_SIZE  ((size_t)2 << 20)
+
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+# define MAP_ANONYMOUS  MAP_ANON
+#endif
+
+#if defined(__linux__) && defined(SYS_mbind)
+/**
+ * Memory policy, from <linux/mempolicy.h>, that spreads the
+ * pages of a mapping round-robin over a set of nodes
+ */
+# define MPOL_INTERLEAVE  3
+
+/**
+ * The number of nodes that `interleave` can spread pages over
+ */
+# define MAX_NODES  (8 * sizeof(unsigned long int) * 16)
+#endif
+
+
+/**
+ * The flags of each of the allocators
+ */
+static const int allocator_flags[4] = {0, 1, 2, 3};
+
+
+#if defined(MPOL_INTERLEAVE)
+/**
+ * Sets a mapping's pages to be spread over the online NUMA nodes,
+ * which must be done before they are touched
+ *
+ * Failure is ignored, the pages are then placed as usual
+ *
+ * @param  ptr   The mapping
+ * @param  size  The size of the mapping
+ */
+static void
+interleave(void *ptr, size_t size)
+{
+	unsigned long int mask[MAX_NODES / (8 * sizeof(unsigned long int))] = {0};
+	const size_t limb_bits = 8 * sizeof(unsigned long int);
+	char buf[256], *p, *end;
+	unsigned long int first, last;
+	ssize_t r;
+	int fd;
+
+	/* The online nodes are listed as ranges, such as "0-1,4" */
+	fd = open("/sys/devices/system/node/online", O_RDONLY);
+	if (fd < 0)
+		return;
+	r = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+	if (r <= 0)
+		return;
+	buf[r] = '\0';
+
+	for (p = buf; *p >= '0' && *p <= '9'; p++) {
+		first = last = strtoul(p, &end, 10);
+		if (*end == '-')
+			last = strtoul(&end[1], &end, 10);
+		for (; first <= last && first < MAX_NODES; first++)
+			mask[first / limb_bits] |= 1UL << (first % limb_bits);
+		if (*(p = end) != ',')
+			break;
+	}
+
+	syscall(SYS_mbind, ptr, size, MPOL_INTERLEAVE, mask, (unsigned long int)MAX_NODES + 1, 0U);
+}
+#endif
+
+
+/**
+ * Maps memory for `kuhn_page_allocator`
+ *
+ * @param   data       The allocator's flags
+ * @param   size       The number of bytes to allocate
+ * @param   alignment  The required alignment, at most a page
+ * @return             The memory, `NULL` on failure
+ */
+static void *
+page_allocate(void *data, size_t size, size_t alignment)
+{
+	int flags = *(const int *)data;
+	size_t page = (size_t)sysconf(_SC_PAGESIZE);
+	char *ptr, *aligned;
+
+	if (alignment > page) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	/* Allocations smaller than a huge page are not worth one */
+	if (!(flags & KUHN_PAGES_HUGE) || size < HUGE_PAGE_SIZE) {
+		size = (size + (page - 1)) & ~(page - 1);
+		ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (ptr == MAP_FAILED)
+			return NULL;
+		goto out;
+	}
+
+	if (size > SIZE_MAX - 2 * HUGE_PAGE_SIZE) {
+		errno = ENOMEM;
+		return NULL;
+	}
+	size = (size + (HUGE_PAGE_SIZE - 1)) & ~(HUGE_PAGE_SIZE - 1);
+
+#if defined(MAP_HUGETLB)
+	/* Reserved huge pages, if the administrator has set any aside */
+	ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (ptr != MAP_FAILED)
+		goto out;
+#endif
+
+	/* Otherwise transparent huge pages, which require the mapping
+	 * to be aligned to the huge page size, so a huge page larger
+	 * mapping is made and the excess on either side is unmapped */
+	ptr = mmap(NULL, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (ptr == MAP_FAILED)
+		return NULL;
+	aligned = (char *)(((uintptr_t)ptr + (HUGE_PAGE_SIZE - 1)) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1));
+	if (aligned != ptr)
+		munmap(ptr, (size_t)(aligned - ptr));
+	if (aligned + size != ptr + size + HUGE_PAGE_SIZE)
+		munmap(aligned + size, (size_t)(ptr + HUGE_PAGE_SIZE - aligned));
+	ptr = aligned;
+#if defined(MADV_HUGEPAGE)
+	madvise(ptr, size, MADV_HUGEPAGE);
+#endif
+
+out:
+#if defined(MPOL_INTERLEAVE)
+	if (flags & KUHN_PAGES_INTERLEAVE)
+		interleave(ptr, size);
+#endif
+	return ptr;
+}
+
+
+/**
+ * Unmaps memory mapped by `page_allocate`
+ *
+ * @param  data       The allocator's flags
+ * @param  ptr        The memory
+ * @param  size       The size the memory was allocated with
+ * @param  alignment  Unused
+ */
+static void
+page_deallocate(void *data, void *ptr, size_t size, size_t alignment)
+{
+	int flags = *(const int *)data;
+	size_t page = (size_t)sysconf(_SC_PAGESIZE);
+
+	(void) alignment;
+
+	if ((flags & KUHN_PAGES_HUGE) && size >= HUGE_PAGE_SIZE)
+		size = (size + (HUGE_PAGE_SIZE - 1)) & ~(HUGE_PAGE_SIZE - 1);
+	else
+		size = (size + (page - 1)) & ~(page - 1);
+	munmap(ptr, size);
+}
+
+
+/**
+ * The allocators, indexed by their flags
+ */
+static const KuhnAllocator page_allocators[4] = {
+	{page_allocate, page_deallocate, (void *)&allocator_flags[0]},
+	{page_allocate, page_deallocate, (void *)&allocator_flags[1]},
+	{page_allocate, page_deallocate, (void *)&allocator_flags[2]},
+	{page_allocate, page_deallocate, (void *)&allocator_flags[3]}
+};
+
+
+const KuhnAllocator *
+kuhn_page_allocator(int flags)
+{
+	return &page_allocators[flags & (KUHN_PAGES_HUGE | KUHN_PAGES_INTERLEAVE)];
+}
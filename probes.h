@@ -0,0 +1,90 @@
+/**
+ * 𝓞(n³) implementation of the Hungarian algorithm
+ * 
+ * Copyright (C) 2011, 2014, 2020  Mattias Andrée
+ * 
+ * This program is free software. It comes without any warranty, to
+ * the extent permitted by applicable law. You can redistribute it
+ * and/or modify it under the terms of the Do What The Fuck You Want
+ * To Public License, Version 2, as published by Sam Hocevar. See
+ * http://sam.zoy.org/wtfpl/COPYING for more details.
+ */
+
+
+#ifndef PROBES_H
+#define PROBES_H
+
+
+/*
+ * USDT probes, for SystemTap, bpftrace, and perf, under the
+ * provider "hungarian". A probe is a single NOP in the code
+ * and a note in the .note.stapsdt section that tells the
+ * tracer where the NOP is and where its arguments can be
+ * found; the tracer replaces the NOP with a breakpoint when
+ * it attaches.
+ *
+ * <sys/sdt.h> is used if it is available, otherwise the notes
+ * are emitted the same way for x86-64 ELF targets. Elsewhere,
+ * or with -DHUNGARIAN_NO_PROBES, the probes are compiled out.
+ *
+ * All arguments are passed as signed 64-bit integers.
+ */
+
+
+#if !defined(HUNGARIAN_NO_PROBES) && !defined(HAVE_SYS_SDT_H) && defined(__has_include)
+# if __has_include(<sys/sdt.h>)
+#  define HAVE_SYS_SDT_H
+# endif
+#endif
+
+
+#if defined(HUNGARIAN_NO_PROBES)
+
+# define PROBE1(name, a)     ((void)0)
+# define PROBE2(name, a, b)  ((void)0)
+
+#elif defined(HAVE_SYS_SDT_H)
+
+# include <sys/sdt.h>
+# define PROBE1(name, a)     STAP_PROBE1(hungarian, name, (int64_t)(a))
+# define PROBE2(name, a, b)  STAP_PROBE2(hungarian, name, (int64_t)(a), (int64_t)(b))
+
+#elif defined(__GNUC__) && defined(__x86_64__) && defined(__ELF__)
+
+# define PROBE_NOTE__(name, args)\
+	"990: nop\n"\
+	".pushsection .note.stapsdt,\"?\",\"note\"\n"\
+	".balign 4\n"\
+	".4byte 992f-991f, 994f-993f, 3\n"\
+	"991: .asciz \"stapsdt\"\n"\
+	"992: .balign 4\n"\
+	"993: .8byte 990b\n"\
+	".8byte _.stapsdt.base\n"\
+	".8byte 0\n"\
+	".asciz \"hungarian\"\n"\
+	".asciz \"" #name "\"\n"\
+	".asciz \"" args "\"\n"\
+	"994: .balign 4\n"\
+	".popsection\n"\
+	".ifndef _.stapsdt.base\n"\
+	".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n"\
+	".weak _.stapsdt.base\n"\
+	".hidden _.stapsdt.base\n"\
+	"_.stapsdt.base: .space 1\n"\
+	".size _.stapsdt.base, 1\n"\
+	".popsection\n"\
+	".endif\n"
+# define PROBE1(name, a)\
+	__asm__ __volatile__ (PROBE_NOTE__(name, "-8@%0") :: "nor"((int64_t)(a)))
+# define PROBE2(name, a, b)\
+	__asm__ __volatile__ (PROBE_NOTE__(name, "-8@%0 -8@%1") :: "nor"((int64_t)(a)), "nor"((int64_t)(b)))
+
+#else
+
+# define PROBE1(name, a)     ((void)0)
+# define PROBE2(name, a, b)  ((void)0)
+
+#endif
+
+
+#endif
@@ -0,0 +1,628 @@
+/**
+ * 𝓞(n³) implementation of the Hungarian algorithm
+ * 
+ * Copyright (C) 2011, 2014, 2020  Mattias Andrée
+ * 
+ * This program is free software. It comes without any warranty, to
+ * the extent permitted by applicable law. You can redistribute it
+ * and/or modify it under the terms of the Do What The Fuck You Want
+ * To Public License, Version 2, as published by Sam Hocevar. See
+ * http://sam.zoy.org/wtfpl/COPYING for more details.
+ */
+
+
+
+#include "common.h"
+#include "probes.h"
+
+
+/*
+ * Each augmentation finds the shortest path from an unassigned row
+ * to a free column in the reduced costs, like `sap_augment`. For
+ * `kuhn_solve_rows`, the rows are only ever fetched in increasing
+ * order, pass by pass, so that a table in a file is read sequentially,
+ * and as the rows thus cannot be visited in the order of their
+ * distance, which Dijkstra's algorithm would require, the distances
+ * are corrected instead: a pass fetches every row whose distance has
+ * improved since it was last fetched, and the search ends when no
+ * such row is left. A row reached later in a pass is fetched in the
+ * same pass, a row reached earlier waits for the next pass.
+ * `kuhn_solve_oracle` and `kuhn_solve_cells` can fetch the rows in
+ * any order, and use Dijkstra's algorithm, see `rows_augment_any`.
+ */
+
+
+/**
+ * Index stored for columns without a row
+ */
+#define NO_ROW  ((KuhnIndex)-1)
+
+
+/**
+ * The state of `kuhn_solve_rows`, 𝓞(n + m) in size
+ */
+typedef struct {
+	/**
+	 * The height of the table
+	 */
+	size_t n;
+
+	/**
+	 * The width of the table
+	 */
+	size_t m;
+
+	/**
+	 * Function that fetches a row, `NULL` if `get_cell` is used
+	 */
+	KuhnRowFunction *get_row;
+
+	/**
+	 * Function that calculates a cell, `NULL` if `get_row` is used
+	 */
+	KuhnCellFunction *get_cell;
+
+	/**
+	 * First argument for `get_row` or `get_cell`
+	 */
+	void *data;
+
+	/**
+	 * Whether the costs are negated, for a maximum assignment
+	 */
+	Boolean maximize;
+
+	/**
+	 * Whether the rows must be fetched in increasing order
+	 */
+	Boolean ordered;
+
+	/**
+	 * Performance counters, may be `NULL`
+	 */
+	KuhnStats *stats;
+
+	/**
+	 * The number of rows fetched during the current augmentation
+	 */
+	uint_fast64_t fetched;
+
+	/**
+	 * The number of passes during the current augmentation
+	 */
+	uint_fast64_t passes;
+
+	/**
+	 * The number of cells calculated with `get_cell`
+	 */
+	uint_fast64_t cells;
+
+	/**
+	 * The allocation that all arrays below are carved from
+	 */
+	void *block;
+
+	/**
+	 * The size of `block`
+	 */
+	size_t size;
+
+	/**
+	 * Row buffer for `get_row`
+	 */
+	Cell *buf;
+
+	/**
+	 * The shortest distance found so far to each column
+	 */
+	Cell *dist;
+
+	/**
+	 * The rows to fetch in the current pass
+	 */
+	Cover *pending;
+
+	/**
+	 * The rows to fetch in the next pass
+	 */
+	Cover *later;
+
+	/**
+	 * The columns whose distances are final, unless `ordered`
+	 */
+	Cover *scanned;
+
+	/**
+	 * The row each column was reached from on its shortest path
+	 */
+	KuhnIndex *way;
+
+	/**
+	 * The row assigned to each column, `NO_ROW` if none is
+	 */
+	KuhnIndex *col_row;
+} Rows;
+
+
+/**
+ * Fetches a row, negated if maximising
+ *
+ * @param   this  The solver state
+ * @param   row   The index of the row
+ * @return        The row's costs, `NULL` on error
+ */
+static const Cell *
+rows_fetch(Rows *this, size_t row)
+{
+	const Cell *c = this->buf;
+	size_t j;
+
+	if (this->get_cell) {
+		for (j = 0; j < this->m; j++)
+			this->buf[j] = this->get_cell(this->data, row, j);
+		this->cells += this->m;
+	} else if (!(c = this->get_row(this->data, row, this->buf))) {
+		return NULL;
+	}
+	this->fetched += 1;
+	if (this->maximize) {
+		for (j = 0; j < this->m; j++)
+			this->buf[j] = -c[j];
+		c = this->buf;
+	}
+	return c;
+}
+
+
+/**
+ * Calculates a cell with `get_cell`, negated if maximising
+ *
+ * @param   this  The solver state
+ * @param   row   The index of the cell's row
+ * @param   col   The index of the cell's column
+ * @return        The cell's cost
+ */
+static Cell
+rows_cell(Rows *this, size_t row, size_t col)
+{
+	Cell cost = this->get_cell(this->data, row, col);
+	this->cells += 1;
+	return this->maximize ? -cost : cost;
+}
+
+
+/**
+ * Makes the potentials feasible, by setting each row's potential
+ * to its least cost, and assigns each row whose cheapest column
+ * is still free to it, in one pass
+ *
+ * @param   this        The solver state
+ * @param   u           Output array for the row potentials
+ * @param   col_of_row  Output array for the assignment, `m` for unassigned rows
+ * @return              0 on success, -1 on error
+ */
+static int
+rows_initialise(Rows *this, Cell *u, KuhnIndex *col_of_row)
+{
+	size_t i, j, best;
+	const Cell *c;
+
+	for (i = 0; i < this->n; i++) {
+		if (!(c = rows_fetch(this, i)))
+			return -1;
+		best = 0;
+		for (j = 1; j < this->m; j++)
+			if (c[best] > c[j] || (c[best] == c[j] && this->col_row[best] != NO_ROW))
+				best = j;
+		u[i] = c[best];
+		col_of_row[i] = (KuhnIndex)this->m;
+		if (this->col_row[best] == NO_ROW) {
+			col_of_row[i] = (KuhnIndex)best;
+			this->col_row[best] = (KuhnIndex)i;
+		}
+	}
+
+	return 0;
+}
+
+
+/**
+ * Updates the potentials after a search for an augmenting path,
+ * and assigns the row along the path
+ *
+ * @param  this        The solver state
+ * @param  row         The row to assign
+ * @param  best        The distance to the free column
+ * @param  free_col    The free column the path ends at
+ * @param  u           Row potentials
+ * @param  v           Column potentials
+ * @param  col_of_row  The assignment, `m` for unassigned rows
+ */
+static void
+rows_flip(Rows *this, size_t row, Cell best, size_t free_col, Cell *u, Cell *v, KuhnIndex *col_of_row)
+{
+	size_t n = this->n, m = this->m, i, j, k;
+
+	/* Everything closer than the free column moves up to it,
+	 * which keeps the reduced costs non-negative and makes
+	 * the path to the free column tight */
+	u[row] += best;
+	for (i = 0; i < n; i++)
+		if (col_of_row[i] < m && this->dist[col_of_row[i]] < best)
+			u[i] += best - this->dist[col_of_row[i]];
+	for (j = 0; j < m; j++)
+		if (this->dist[j] < best)
+			v[j] -= best - this->dist[j];
+
+	for (j = free_col;;) {
+		i = this->way[j];
+		k = col_of_row[i];
+		col_of_row[i] = (KuhnIndex)j;
+		this->col_row[j] = (KuhnIndex)i;
+		if (i == row)
+			break;
+		j = k;
+	}
+}
+
+
+/**
+ * Assigns an unassigned row along a shortest augmenting path,
+ * keeping the potentials feasible and every assigned cell tight
+ *
+ * @param   this        The solver state
+ * @param   row         The row to assign
+ * @param   u           Row potentials
+ * @param   v           Column potentials
+ * @param   col_of_row  The assignment, `m` for unassigned rows
+ * @param   deadline    The deadline, may be `NULL`
+ * @return              0 on success, 1 if the deadline was reached, in
+ *                      which case nothing is changed, -1 on error
+ */
+static int
+rows_augment(Rows *this, size_t row, Cell *u, Cell *v, KuhnIndex *col_of_row,
+             const struct timespec *deadline)
+{
+	size_t n = this->n, m = this->m, limbs = COVER_LIMBS(n), i, j, b, free_col = m;
+	Cell best = CELL_MAX, di, d;
+	KuhnIndex k;
+	Cover *swap;
+	const Cell *c;
+	Boolean more;
+
+	for (j = 0; j < m; j++)
+		this->dist[j] = CELL_MAX;
+	memset(this->pending, 0, limbs * sizeof(Cover));
+	memset(this->later, 0, limbs * sizeof(Cover));
+	COVER(this->pending, row);
+
+	do {
+		this->passes += 1;
+		for (b = 0; b < limbs; b++) {
+			while (this->pending[b]) {
+				i = (b << 6) + LOWEST_BIT(this->pending[b]);
+				this->pending[b] &= this->pending[b] - 1;
+
+				/* A row is as far as its column, and cannot
+				 * lead anywhere closer than the free column */
+				di = i == row ? 0 : this->dist[col_of_row[i]];
+				if (di >= best)
+					continue;
+
+				if (!(c = rows_fetch(this, i)))
+					return -1;
+				for (j = 0; j < m; j++) {
+					d = di + c[j] - u[i] - v[j];
+					if (d >= this->dist[j] || d >= best)
+						continue;
+					this->dist[j] = d;
+					this->way[j] = (KuhnIndex)i;
+					if ((k = this->col_row[j]) == NO_ROW) {
+						best = d;
+						free_col = j;
+					} else {
+						COVER(k > i ? this->pending : this->later, k);
+					}
+				}
+			}
+		}
+
+		swap = this->pending;
+		this->pending = this->later;
+		this->later = swap;
+
+		if (kuhn_expired(deadline))
+			return 1;
+
+		more = 0;
+		for (b = 0; b < limbs && !more; b++)
+			more = !!this->pending[b];
+	} while (more);
+
+	if (free_col == m) {
+		errno = ERANGE;
+		return -1;
+	}
+
+	rows_flip(this, row, best, free_col, u, v, col_of_row);
+	return 0;
+}
+
+
+/**
+ * Like `rows_augment`, but for rows that can be fetched in any
+ * order, so that they are scanned in the order of their distance,
+ * as by Dijkstra's algorithm, each at most once, and the search
+ * ends as soon as the nearest free column is reached; with
+ * `get_cell`, only the cells that are needed are calculated
+ *
+ * @param   this        The solver state
+ * @param   row         The row to assign
+ * @param   u           Row potentials
+ * @param   v           Column potentials
+ * @param   col_of_row  The assignment, `m` for unassigned rows
+ * @param   deadline    The deadline, may be `NULL`
+ * @return              0 on success, 1 if the deadline was reached, in
+ *                      which case nothing is changed, -1 on error
+ */
+static int
+rows_augment_any(Rows *this, size_t row, Cell *u, Cell *v, KuhnIndex *col_of_row,
+                 const struct timespec *deadline)
+{
+	size_t m = this->m, i = row, j, nearest;
+	Cell di = 0, d, min;
+	const Cell *c = NULL;
+
+	for (j = 0; j < m; j++)
+		this->dist[j] = CELL_MAX;
+	memset(this->scanned, 0, COVER_LIMBS(m) * sizeof(Cover));
+
+	for (;;) {
+		if (this->get_cell)
+			this->fetched += 1;
+		else if (!(c = rows_fetch(this, i)))
+			return -1;
+		min = CELL_MAX;
+		nearest = m;
+		for (j = 0; j < m; j++) {
+			if (COVERED(this->scanned, j))
+				continue;
+			/* The reduced costs are non-negative, so a column
+			 * that is no farther than the row cannot get closer,
+			 * and its cell need not be calculated */
+			if (di < this->dist[j]) {
+				d = di + (c ? c[j] : rows_cell(this, i, j)) - u[i] - v[j];
+				if (d < this->dist[j]) {
+					this->dist[j] = d;
+					this->way[j] = (KuhnIndex)i;
+				}
+			}
+			if (this->dist[j] < min) {
+				min = this->dist[j];
+				nearest = j;
+			}
+		}
+
+		if (nearest == m) {
+			errno = ERANGE;
+			return -1;
+		}
+		COVER(this->scanned, nearest);
+		if (this->col_row[nearest] == NO_ROW)
+			break;
+		i = this->col_row[nearest];
+		di = min;
+
+		if (kuhn_expired(deadline))
+			return 1;
+	}
+
+	/* The columns that are not scanned are no closer than
+	 * the free column, so the potentials are updated the
+	 * same way as after `rows_augment` */
+	rows_flip(this, row, min, nearest, u, v, col_of_row);
+	return 0;
+}
+
+
+/**
+ * Assigns each unassigned row to its cheapest free column, in one pass
+ *
+ * @param   this        The solver state
+ * @param   col_of_row  The assignment, `m` for unassigned rows
+ * @param   costp       The cost, of the rows' assigned cells is added to it
+ * @return              0 on success, -1 on error
+ */
+static int
+rows_complete(Rows *this, KuhnIndex *col_of_row, Cell *costp)
+{
+	size_t i, j, best;
+	const Cell *c;
+
+	for (i = 0; i < this->n; i++) {
+		if (col_of_row[i] < this->m)
+			continue;
+		if (!(c = rows_fetch(this, i)))
+			return -1;
+		best = this->m;
+		for (j = 0; j < this->m; j++)
+			if (this->col_row[j] == NO_ROW && (best == this->m || c[best] > c[j]))
+				best = j;
+		col_of_row[i] = (KuhnIndex)best;
+		this->col_row[best] = (KuhnIndex)i;
+		*costp += c[best];
+	}
+
+	return 0;
+}
+
+
+/**
+ * Solves a table that is fetched a row at a time,
+ * or calculated a cell at a time
+ *
+ * @param   n         The height of the table
+ * @param   m         The width of the table
+ * @param   get_row   Function that fetches a row, or `NULL`
+ * @param   get_cell  Function that calculates a cell, or `NULL`
+ * @param   data      First argument for `get_row` or `get_cell`
+ * @param   ordered   Whether the rows must be fetched in increasing order
+ * @param   options   Solver options, may be `NULL`
+ * @param   result    Output parameter for the result
+ * @param   name      The name of the span in the trace
+ * @return            0 on success, -1 on error
+ */
+static int
+rows_solve(size_t n, size_t m, KuhnRowFunction *get_row, KuhnCellFunction *get_cell, void *data,
+           Boolean ordered, const KuhnOptions *options, KuhnResult *result, const char *name)
+{
+	const KuhnAllocator *allocator = options && options->allocator ? options->allocator : &kuhn_default_allocator;
+	const struct timespec *deadline = options ? options->deadline : NULL;
+	KuhnTrace *trace = options ? options->trace : NULL;
+	uint_fast64_t start = trace ? kuhn_now() : 0;
+	size_t i, limbs = 2 * COVER_LIMBS(n) + COVER_LIMBS(m);
+	Cell *u, *v;
+	Rows this;
+	char *block;
+	int r = 0;
+
+	if (n > m) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (m >= KUHN_INDEX_MAX || m > (SIZE_MAX / 4 - limbs * sizeof(Cover)) / (2 * sizeof(Cell) + 2 * sizeof(KuhnIndex))) {
+		errno = ERANGE;
+		return -1;
+	}
+
+	memset(&this, 0, sizeof(this));
+	this.n = n;
+	this.m = m;
+	this.get_row = get_row;
+	this.get_cell = get_cell;
+	this.ordered = ordered;
+	this.data = data;
+	this.maximize = options ? options->maximize : 0;
+	this.stats = options ? options->stats : NULL;
+	if (this.stats)
+		memset(this.stats, 0, sizeof(*this.stats));
+
+	result->allocator = allocator;
+	result->height = n;
+	result->width = m;
+	result->row_potential = u = kuhn_allocate(allocator, n * sizeof(Cell), sizeof(Cell));
+	result->col_potential = v = kuhn_allocate(allocator, m * sizeof(Cell), sizeof(Cell));
+	result->col_of_row = kuhn_allocate(allocator, n * sizeof(KuhnIndex), sizeof(KuhnIndex));
+	this.size = 2 * m * sizeof(Cell) + limbs * sizeof(Cover) + 2 * m * sizeof(KuhnIndex);
+	this.block = block = kuhn_allocate(allocator, this.size, sizeof(Cell));
+	if (!u || !v || !result->col_of_row || !block) {
+		kuhn_deallocate(allocator, this.block, this.size, sizeof(Cell));
+		kuhn_result_destroy(result);
+		return -1;
+	}
+	this.buf     = (Cell *)(void *)block;
+	this.dist    = &this.buf[m];
+	this.pending = (Cover *)(void *)&this.dist[m];
+	this.later   = &this.pending[COVER_LIMBS(n)];
+	this.scanned = &this.later[COVER_LIMBS(n)];
+	this.way     = (KuhnIndex *)(void *)&this.scanned[COVER_LIMBS(m)];
+	this.col_row = &this.way[m];
+
+	memset(v, 0, m * sizeof(Cell));
+	for (i = 0; i < m; i++)
+		this.col_row[i] = NO_ROW;
+
+	result->optimal = 0;
+	if (rows_initialise(&this, u, result->col_of_row))
+		goto fail;
+	if (this.stats) {
+		this.stats->rows_fetched += this.fetched;
+		this.stats->row_passes += 1;
+	}
+
+	for (i = 0; i < n; i++) {
+		if (result->col_of_row[i] < m)
+			continue;
+		this.fetched = this.passes = 0;
+		r = (ordered ? rows_augment : rows_augment_any)(&this, i, u, v, result->col_of_row, deadline);
+		if (this.stats) {
+			this.stats->augmentations += !r;
+			this.stats->rows_fetched += this.fetched;
+			this.stats->row_passes += this.passes;
+		}
+		if (r < 0)
+			goto fail;
+		if (r > 0)
+			break;
+		PROBE2(rows_augment, this.fetched, this.passes);
+	}
+	result->optimal = !r;
+
+	/* The assigned cells are tight, so their costs are given by the potentials */
+	result->cost = 0;
+	for (i = 0; i < n; i++)
+		if (result->col_of_row[i] < m)
+			result->cost += u[i] + v[result->col_of_row[i]];
+	if (!result->optimal) {
+		this.fetched = 0;
+		if (rows_complete(&this, result->col_of_row, &result->cost))
+			goto fail;
+		if (this.stats) {
+			this.stats->rows_fetched += this.fetched;
+			this.stats->row_passes += 1;
+		}
+	}
+
+	/* The potentials are always feasible, and unassigned columns
+	 * keep a zero potential, so this is the cost if optimal */
+	result->lower_bound = 0;
+	for (i = 0; i < n; i++)
+		result->lower_bound += u[i];
+	for (i = 0; i < m; i++)
+		result->lower_bound += v[i];
+
+	if (this.maximize) {
+		for (i = 0; i < n; i++)
+			u[i] = -u[i];
+		for (i = 0; i < m; i++)
+			v[i] = -v[i];
+		result->lower_bound = -result->lower_bound;
+		result->cost = -result->cost;
+	}
+
+	if (this.stats)
+		this.stats->cells_evaluated = this.cells;
+	kuhn_deallocate(allocator, this.block, this.size, sizeof(Cell));
+	if (trace)
+		trace_span(trace, name, start, kuhn_now());
+	return 0;
+
+fail:
+	kuhn_deallocate(allocator, this.block, this.size, sizeof(Cell));
+	kuhn_result_destroy(result);
+	return -1;
+}
+
+
+int
+kuhn_solve_rows(size_t n, size_t m, KuhnRowFunction *get_row, void *data,
+                const KuhnOptions *options, KuhnResult *result)
+{
+	return rows_solve(n, m, get_row, NULL, data, 1, options, result, "kuhn_solve_rows");
+}
+
+
+int
+kuhn_solve_oracle(size_t n, size_t m, KuhnRowFunction *get_row, void *data,
+                  const KuhnOptions *options, KuhnResult *result)
+{
+	return rows_solve(n, m, get_row, NULL, data, 0, options, result, "kuhn_solve_oracle");
+}
+
+
+int
+kuhn_solve_cells(size_t n, size_t m, KuhnCellFunction *get_cell, void *data,
+                 const KuhnOptions *options, KuhnResult *result)
+{
+	return rows_solve(n, m, NULL, get_cell, data, 0, options, result, "kuhn_solve_cells");
+}
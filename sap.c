@@ -0,0 +1,83 @@
+/**
+ * 𝓞(n³) implementation of the Hungarian algorithm
+ * 
+ * Copyright (C) 2011, 2014, 2020  Mattias Andrée
+ * 
+ * This program is free software. It comes without any warranty, to
+ * the extent permitted by applicable law. You can redistribute it
+ * and/or modify it under the terms of the Do What The Fuck You Want
+ * To Public License, Version 2, as published by Sam Hocevar. See
+ * http://sam.zoy.org/wtfpl/COPYING for more details.
+ */
+
+
+#include "common.h"
+
+
+int
+sap_augment(size_t row, size_t ncols, const size_t *cols, Cell *u, Cell *v,
+            ssize_t *row_col, ssize_t *col_row, SapScratch *scratch,
+            SapRowFunction *get_row, void *ctx)
+{
+	Cell *minv = scratch->minv, delta, cur, ui;
+	ssize_t *way = scratch->way, j0 = -1, j1;
+	size_t *todo = scratch->todo, ntodo = ncols, i, j, k, at = 0;
+	const Cell *c;
+
+	/* todo[0, ntodo) are the columns not yet reached, todo[ntodo, ncols) are reached */
+	for (k = 0; k < ncols; k++) {
+		j = todo[k] = cols[k];
+		minv[j] = CELL_MAX;
+	}
+
+	for (i = row;;) {
+		c = get_row(ctx, i, scratch->buf);
+		ui = u[i];
+
+		delta = CELL_MAX;
+		j1 = -1;
+		for (k = 0; k < ntodo; k++) {
+			j = todo[k];
+			if (c[j] != FORBIDDEN) {
+				cur = c[j] - ui - v[j];
+				if (minv[j] > cur) {
+					minv[j] = cur;
+					way[j] = j0;
+				}
+			}
+			if (delta > minv[j]) {
+				delta = minv[j];
+				j1 = (ssize_t)j;
+				at = k;
+			}
+		}
+		if (j1 < 0)
+			return -1;
+
+		u[row] += delta;
+		for (k = ntodo; k < ncols; k++) {
+			j = todo[k];
+			u[col_row[j]] += delta;
+			v[j] -= delta;
+		}
+		for (k = 0; k < ntodo; k++)
+			if (minv[todo[k]] != CELL_MAX)
+				minv[todo[k]] -= delta;
+
+		todo[at] = todo[--ntodo];
+		todo[ntodo] = (size_t)j1;
+		j0 = j1;
+		if (col_row[j0] < 0)
+			break;
+		i = (size_t)col_row[j0];
+	}
+
+	for (; j0 >= 0; j0 = j1) {
+		j1 = way[j0];
+		i = j1 < 0 ? row : (size_t)col_row[j1];
+		col_row[j0] = (ssize_t)i;
+		row_col[i] = j0;
+	}
+
+	return 0;
+}
@@ -0,0 +1,639 @@
+/**
+ * 𝓞(n³) implementation of the Hungarian algorithm
+ * 
+ * Copyright (C) 2011, 2014, 2020  Mattias Andrée
+ * 
+ * This program is free software. It comes without any warranty, to
+ * the extent permitted by applicable law. You can redistribute it
+ * and/or modify it under the terms of the Do What The Fuck You Want
+ * To Public License, Version 2, as published by Sam Hocevar. See
+ * http://sam.zoy.org/wtfpl/COPYING for more details.
+ */
+
+
+#include "common.h"
+
+
+/*
+ * The solver always works on a square problem: when there are
+ * more columns than rows it is padded with phantom rows, and
+ * when there are more rows than columns it is padded with
+ * phantom columns. Every cell in a phantom row or column costs
+ * zero, so the phantoms do not affect which assignment of the
+ * real rows and columns is optimal. Because the problem is
+ * square and fully matched, any feasible potentials under which
+ * every assigned cell is tight proves optimality, and each
+ * update below only needs to leave a single row unassigned
+ * and reassign it with one augmentation.
+ */
+
+
+/**
+ * Slot states
+ */
+enum {
+	FREE = 0,
+	REAL,
+	PHANTOM
+};
+
+
+/**
+ * Value type for slot states
+ */
+typedef int_fast8_t SlotState;
+
+
+/**
+ * Set of row or column slots
+ */
+typedef struct {
+	/**
+	 * The number of allocated slots
+	 */
+	size_t cap;
+
+	/**
+	 * The number of slots that are not free
+	 */
+	size_t count;
+
+	/**
+	 * The number of phantom slots
+	 */
+	size_t phantoms;
+
+	/**
+	 * The state of each slot
+	 */
+	SlotState *state;
+
+	/**
+	 * The indices of the slots that are not free
+	 */
+	size_t *active;
+
+	/**
+	 * The position of each slot that is not free in `active`
+	 */
+	size_t *pos;
+
+	/**
+	 * The potential of each slot
+	 */
+	Cell *potential;
+
+	/**
+	 * The slot in the other set assigned to each slot, -1 if none
+	 */
+	ssize_t *mate;
+} Slots;
+
+
+struct kuhn_solver {
+	/**
+	 * The rows
+	 */
+	Slots rows;
+
+	/**
+	 * The columns
+	 */
+	Slots cols;
+
+	/**
+	 * `rows.cap` rows with `cols.cap` cells each, cells
+	 * in phantom rows and phantom columns are zero
+	 */
+	Cell **cost;
+
+	/**
+	 * Scratch memory for `sap_augment`, sized for `cols.cap`
+	 */
+	SapScratch scratch;
+};
+
+
+/**
+ * Grows the arrays of a slot set
+ *
+ * @param   this  The slot set
+ * @param   cap   The new number of slots
+ * @return        0 on success, -1 on error
+ */
+static int
+slots_grow(Slots *this, size_t cap)
+{
+	void *p;
+
+#define GROW(ARRAY)\
+	do {\
+		if (!(p = realloc(this->ARRAY, cap * sizeof(*this->ARRAY))))\
+			return -1;\
+		this->ARRAY = p;\
+	} while (0)
+
+	GROW(state);
+	GROW(active);
+	GROW(pos);
+	GROW(potential);
+	GROW(mate);
+
+#undef GROW
+
+	memset(&this->state[this->cap], 0, (cap - this->cap) * sizeof(*this->state)); /* FREE == 0 */
+	this->cap = cap;
+	return 0;
+}
+
+
+/**
+ * Deallocates the arrays of a slot set
+ *
+ * @param  this  The slot set
+ */
+static void
+slots_destroy(Slots *this)
+{
+	free(this->state);
+	free(this->active);
+	free(this->pos);
+	free(this->potential);
+	free(this->mate);
+}
+
+
+/**
+ * Takes a slot into use
+ *
+ * @param  this   The slot set
+ * @param  i      The slot
+ * @param  state  `REAL` or `PHANTOM`
+ */
+static void
+slots_activate(Slots *this, size_t i, SlotState state)
+{
+	this->state[i] = state;
+	this->pos[i] = this->count;
+	this->active[this->count++] = i;
+	this->phantoms += state == PHANTOM;
+	this->potential[i] = 0;
+	this->mate[i] = -1;
+}
+
+
+/**
+ * Takes a slot out of use
+ *
+ * @param  this  The slot set
+ * @param  i     The slot
+ */
+static void
+slots_deactivate(Slots *this, size_t i)
+{
+	size_t last = this->active[--this->count];
+
+	this->active[this->pos[i]] = last;
+	this->pos[last] = this->pos[i];
+	this->phantoms -= this->state[i] == PHANTOM;
+	this->state[i] = FREE;
+}
+
+
+/**
+ * Finds a slot in a specific state
+ *
+ * @param   this   The slot set
+ * @param   state  The state
+ * @return         The index of the slot, -1 if none
+ */
+#if defined(__GNUC__)
+__attribute__((__pure__))
+#endif
+static ssize_t
+slots_find(const Slots *this, SlotState state)
+{
+	size_t i;
+	for (i = 0; i < this->cap; i++)
+		if (this->state[i] == state)
+			return (ssize_t)i;
+	return -1;
+}
+
+
+/**
+ * Makes room for another row
+ *
+ * @param   this  The solver
+ * @return        The index of a free row slot, -1 on error
+ */
+static ssize_t
+solver_free_row(KuhnSolver *this)
+{
+	ssize_t r = slots_find(&this->rows, FREE);
+	size_t i, cap;
+	void *p;
+
+	if (r >= 0)
+		return r;
+
+	cap = this->rows.cap ? this->rows.cap * 2 : 1;
+	if (!(p = realloc(this->cost, cap * sizeof(*this->cost))))
+		return -1;
+	this->cost = p;
+	for (i = this->rows.cap; i < cap; i++)
+		if (!(this->cost[i] = calloc(this->cols.cap, sizeof(Cell))))
+			goto fail;
+	r = (ssize_t)this->rows.cap;
+	if (slots_grow(&this->rows, cap))
+		goto fail;
+	return r;
+
+fail:
+	while (i-- > this->rows.cap)
+		free(this->cost[i]);
+	return -1;
+}
+
+
+/**
+ * Makes room for another column
+ *
+ * @param   this  The solver
+ * @return        The index of a free column slot, -1 on error
+ */
+static ssize_t
+solver_free_col(KuhnSolver *this)
+{
+	ssize_t c = slots_find(&this->cols, FREE);
+	size_t i, cap;
+	void *p;
+
+	if (c >= 0)
+		return c;
+
+	cap = this->cols.cap ? this->cols.cap * 2 : 1;
+	for (i = 0; i < this->rows.cap; i++) {
+		if (!(p = realloc(this->cost[i], cap * sizeof(Cell))))
+			return -1;
+		this->cost[i] = p;
+	}
+
+#define GROW(ARRAY)\
+	do {\
+		if (!(p = realloc(this->scratch.ARRAY, cap * sizeof(*this->scratch.ARRAY))))\
+			return -1;\
+		this->scratch.ARRAY = p;\
+	} while (0)
+
+	GROW(minv);
+	GROW(way);
+	GROW(todo);
+	GROW(buf);
+
+#undef GROW
+
+	c = (ssize_t)this->cols.cap;
+	if (slots_grow(&this->cols, cap))
+		return -1;
+	return c;
+}
+
+
+/**
+ * Row fetcher for `sap_augment`
+ */
+static const Cell *
+solver_get_row(void *ctx, size_t row, Cell *buf)
+{
+	(void) buf;
+	return ((KuhnSolver *)ctx)->cost[row];
+}
+
+
+/**
+ * Assigns the only unassigned row
+ *
+ * @param   this  The solver
+ * @param   row   The unassigned row
+ * @return        0 on success, -1 on error
+ */
+static int
+solver_augment(KuhnSolver *this, size_t row)
+{
+	return sap_augment(row, this->cols.count, this->cols.active,
+	                   this->rows.potential, this->cols.potential,
+	                   this->rows.mate, this->cols.mate,
+	                   &this->scratch, solver_get_row, this);
+}
+
+
+/**
+ * Lowers a row's potential so that it is feasible for every column
+ *
+ * @param  this  The solver
+ * @param  row   The row
+ */
+static void
+solver_fit_row(KuhnSolver *this, size_t row)
+{
+	Cell min = CELL_MAX, *c = this->cost[row], *v = this->cols.potential;
+	size_t k, j;
+
+	for (k = 0; k < this->cols.count; k++) {
+		j = this->cols.active[k];
+		if (min > c[j] - v[j])
+			min = c[j] - v[j];
+	}
+	this->rows.potential[row] = this->cols.count ? min : 0;
+}
+
+
+/**
+ * Lowers a column's potential so that it is feasible for every row
+ *
+ * @param  this  The solver
+ * @param  col   The column
+ */
+static void
+solver_fit_col(KuhnSolver *this, size_t col)
+{
+	Cell min = CELL_MAX, *u = this->rows.potential;
+	size_t k, i;
+
+	for (k = 0; k < this->rows.count; k++) {
+		i = this->rows.active[k];
+		if (min > this->cost[i][col] - u[i])
+			min = this->cost[i][col] - u[i];
+	}
+	this->cols.potential[col] = this->rows.count ? min : 0;
+}
+
+
+/**
+ * Unassigns a row from its column
+ *
+ * @param  this  The solver
+ * @param  row   The row
+ */
+static void
+solver_unassign(KuhnSolver *this, size_t row)
+{
+	ssize_t col = this->rows.mate[row];
+	if (col >= 0) {
+		this->cols.mate[col] = -1;
+		this->rows.mate[row] = -1;
+	}
+}
+
+
+KuhnSolver *
+kuhn_solver_create(size_t n, size_t m)
+{
+	KuhnSolver *this = calloc(1, sizeof(*this));
+	size_t i;
+
+	if (!this)
+		return NULL;
+
+	n += !n;
+	m += !m;
+	if (!(this->cost = calloc(n, sizeof(*this->cost))))
+		goto fail;
+	if (slots_grow(&this->rows, n) || slots_grow(&this->cols, m))
+		goto fail;
+	for (i = 0; i < n; i++)
+		if (!(this->cost[i] = calloc(m, sizeof(Cell))))
+			goto fail;
+
+	this->scratch.minv = malloc(m * sizeof(*this->scratch.minv));
+	this->scratch.way  = malloc(m * sizeof(*this->scratch.way));
+	this->scratch.todo = malloc(m * sizeof(*this->scratch.todo));
+	this->scratch.buf  = malloc(m * sizeof(*this->scratch.buf));
+	if (!this->scratch.minv || !this->scratch.way || !this->scratch.todo || !this->scratch.buf)
+		goto fail;
+
+	return this;
+
+fail:
+	kuhn_solver_destroy(this);
+	return NULL;
+}
+
+
+void
+kuhn_solver_destroy(KuhnSolver *this)
+{
+	size_t i;
+
+	if (!this)
+		return;
+
+	if (this->cost)
+		for (i = 0; i < this->rows.cap; i++)
+			free(this->cost[i]);
+	free(this->cost);
+	slots_destroy(&this->rows);
+	slots_destroy(&this->cols);
+	free(this->scratch.minv);
+	free(this->scratch.way);
+	free(this->scratch.todo);
+	free(this->scratch.buf);
+	free(this);
+}
+
+
+ssize_t
+kuhn_solver_add_row(KuhnSolver *this, const Cell costs[])
+{
+	ssize_t r, q = -1;
+	size_t k, j;
+	Cell *c;
+
+	if (this->rows.phantoms) {
+		/* Replace a phantom row, its column is freed for the new row */
+		r = slots_find(&this->rows, PHANTOM);
+		this->rows.state[r] = REAL;
+		this->rows.phantoms -= 1;
+		solver_unassign(this, (size_t)r);
+	} else {
+		/* Grow the problem with the new row and a phantom column */
+		if ((r = solver_free_row(this)) < 0 || (q = solver_free_col(this)) < 0)
+			return -1;
+		for (k = 0; k < this->rows.count; k++)
+			this->cost[this->rows.active[k]][q] = 0;
+		slots_activate(&this->cols, (size_t)q, PHANTOM);
+		slots_activate(&this->rows, (size_t)r, REAL);
+	}
+
+	c = this->cost[r];
+	for (k = 0; k < this->cols.count; k++) {
+		j = this->cols.active[k];
+		c[j] = this->cols.state[j] == REAL ? costs[j] : 0;
+	}
+
+	if (q >= 0) {
+		/* The row is not yet assigned, so it does not restrict the phantom column */
+		this->rows.count -= 1;
+		solver_fit_col(this, (size_t)q);
+		this->rows.count += 1;
+	}
+	solver_fit_row(this, (size_t)r);
+
+	if (solver_augment(this, (size_t)r)) {
+		errno = EDOM;
+		return -1;
+	}
+	return r;
+}
+
+
+ssize_t
+kuhn_solver_add_col(KuhnSolver *this, const Cell costs[])
+{
+	ssize_t c, p = -1, row;
+	size_t k, i;
+
+	if (this->cols.phantoms) {
+		/* Replace a phantom column, the row assigned to it is reassigned */
+		c = slots_find(&this->cols, PHANTOM);
+		this->cols.state[c] = REAL;
+		this->cols.phantoms -= 1;
+		row = this->cols.mate[c];
+		solver_unassign(this, (size_t)row);
+	} else {
+		/* Grow the problem with the new column and a phantom row */
+		if ((c = solver_free_col(this)) < 0 || (p = solver_free_row(this)) < 0)
+			return -1;
+		memset(this->cost[p], 0, this->cols.cap * sizeof(Cell));
+		row = p;
+	}
+
+	for (k = 0; k < this->rows.count; k++) {
+		i = this->rows.active[k];
+		this->cost[i][c] = this->rows.state[i] == REAL ? costs[i] : 0;
+	}
+
+	if (p >= 0) {
+		slots_activate(&this->cols, (size_t)c, REAL);
+		solver_fit_col(this, (size_t)c);
+		slots_activate(&this->rows, (size_t)p, PHANTOM);
+		solver_fit_row(this, (size_t)p);
+	} else {
+		solver_fit_col(this, (size_t)c);
+	}
+
+	if (solver_augment(this, (size_t)row)) {
+		errno = EDOM;
+		return -1;
+	}
+	return c;
+}
+
+
+int
+kuhn_solver_remove_row(KuhnSolver *this, size_t row)
+{
+	ssize_t q, col;
+	size_t mate;
+
+	if (row >= this->rows.cap || this->rows.state[row] != REAL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (this->cols.phantoms) {
+		/* Shrink the problem by removing the row and a phantom column */
+		q = slots_find(&this->cols, PHANTOM);
+		col = this->rows.mate[row];
+		mate = (size_t)this->cols.mate[q];
+		solver_unassign(this, row);
+		slots_deactivate(&this->rows, row);
+		slots_deactivate(&this->cols, (size_t)q);
+		if (col == q)
+			return 0;
+		solver_unassign(this, mate);
+		return solver_augment(this, mate);
+	}
+
+	/* Turn the row into a phantom row */
+	memset(this->cost[row], 0, this->cols.cap * sizeof(Cell));
+	this->rows.state[row] = PHANTOM;
+	this->rows.phantoms += 1;
+	solver_unassign(this, row);
+	solver_fit_row(this, row);
+	return solver_augment(this, row);
+}
+
+
+int
+kuhn_solver_remove_col(KuhnSolver *this, size_t col)
+{
+	ssize_t p, row;
+	size_t k, mate;
+
+	if (col >= this->cols.cap || this->cols.state[col] != REAL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (this->rows.phantoms) {
+		/* Shrink the problem by removing the column and a phantom row */
+		p = slots_find(&this->rows, PHANTOM);
+		row = this->cols.mate[col];
+		solver_unassign(this, (size_t)row);
+		solver_unassign(this, (size_t)p);
+		slots_deactivate(&this->cols, col);
+		slots_deactivate(&this->rows, (size_t)p);
+		if (row == p)
+			return 0;
+		return solver_augment(this, (size_t)row);
+	}
+
+	/* Turn the column into a phantom column */
+	for (k = 0; k < this->rows.count; k++)
+		this->cost[this->rows.active[k]][col] = 0;
+	this->cols.state[col] = PHANTOM;
+	this->cols.phantoms += 1;
+	mate = (size_t)this->cols.mate[col];
+	solver_unassign(this, mate);
+	solver_fit_col(this, col);
+	return solver_augment(this, mate);
+}
+
+
+ssize_t
+kuhn_solver_col_of(const KuhnSolver *this, size_t row)
+{
+	ssize_t col;
+	if (row >= this->rows.cap || this->rows.state[row] != REAL)
+		return -1;
+	col = this->rows.mate[row];
+	return this->cols.state[col] == REAL ? col : -1;
+}
+
+
+ssize_t
+kuhn_solver_row_of(const KuhnSolver *this, size_t col)
+{
+	ssize_t row;
+	if (col >= this->cols.cap || this->cols.state[col] != REAL)
+		return -1;
+	row = this->cols.mate[col];
+	return this->rows.state[row] == REAL ? row : -1;
+}
+
+
+Cell
+kuhn_solver_cost(const KuhnSolver *this)
+{
+	Cell sum = 0;
+	size_t k, i;
+
+	for (k = 0; k < this->rows.count; k++) {
+		i = this->rows.active[k];
+		sum += this->cost[i][this->rows.mate[i]];
+	}
+
+	return sum;
+}
@@ -0,0 +1,581 @@
+/**
+ * 𝓞(n³) implementation of the Hungarian algorithm
+ * 
+ * Copyright (C) 2011, 2014, 2020  Mattias Andrée
+ * 
+ * This program is free software. It comes without any warranty, to
+ * the extent permitted by applicable law. You can redistribute it
+ * and/or modify it under the terms of the Do What The Fuck You Want
+ * To Public License, Version 2, as published by Sam Hocevar. See
+ * http://sam.zoy.org/wtfpl/COPYING for more details.
+ */
+
+
+#include "stream.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+
+/**
+ * The number of problems that can be in flight at once,
+ * one being read, one being solved, one being written,
+ * and one more so that a slow stage does not stall the
+ * stage before it on every problem
+ */
+#define STREAM_SLOTS  4
+
+/**
+ * The size of the input buffer
+ */
+#define READER_SIZE  (64 << 10)
+
+/**
+ * The longest integer accepted in a text frame
+ */
+#define TOKEN_MAX  64
+
+
+/**
+ * Buffered input from a file descriptor
+ */
+typedef struct {
+	int fd;
+	unsigned char buf[READER_SIZE];
+	size_t head; /* The index of the first unconsumed byte */
+	size_t tail; /* The index after the last read byte */
+	Boolean eof;
+} Reader;
+
+/**
+ * A problem in flight
+ */
+typedef struct {
+	Matrix matrix;
+	KuhnIndex *col_of_row;  /* The assignment, copied out of the workspace */
+	size_t col_of_row_size; /* The capacity of `col_of_row` */
+	Cell cost;
+} Slot;
+
+/**
+ * The state shared by the stages of the pipeline
+ *
+ * A problem is read into the slot at `read % STREAM_SLOTS`,
+ * which is free when `read - written < STREAM_SLOTS`, after
+ * which the counters `read`, `solved`, and `written` pass
+ * over it in turn
+ */
+typedef struct {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	Slot slots[STREAM_SLOTS];
+	size_t read, solved, written;
+	Boolean input_done;  /* `read` will not grow */
+	Boolean solve_done;  /* `solved` will not grow */
+	Boolean failed;      /* The writer has failed */
+	int read_error;      /* errno for the reader, 0 at end of input */
+	int write_error;     /* errno for the writer */
+	Reader reader;
+	unsigned char *row;  /* Buffer for a row of a binary frame */
+	size_t row_size;
+	void *workspace;     /* Memory for `kuhn_solve_in`, shared by all problems */
+	size_t workspace_size;
+	const KuhnAllocator *allocator; /* The allocator of `workspace`, `NULL` for malloc(3) */
+	FILE *output;
+	Boolean binary_output;
+} Stream;
+
+
+/**
+ * Reads more input, moving the unconsumed input to
+ * the beginning of the buffer if it is not already
+ *
+ * @param   this  The reader
+ * @return        The number of bytes read, 0 at end
+ *                of input or if the buffer is full,
+ *                -1 on error
+ */
+static ssize_t
+reader_fill(Reader *this)
+{
+	ssize_t r;
+
+	if (this->head) {
+		memmove(this->buf, &this->buf[this->head], this->tail - this->head);
+		this->tail -= this->head;
+		this->head = 0;
+	}
+	if (this->eof || this->tail == sizeof(this->buf))
+		return 0;
+	do {
+		r = read(this->fd, &this->buf[this->tail], sizeof(this->buf) - this->tail);
+	} while (r < 0 && errno == EINTR);
+	if (r == 0)
+		this->eof = 1;
+	else if (r > 0)
+		this->tail += (size_t)r;
+	return r;
+}
+
+
+/**
+ * Skips whitespace and returns the next byte without consuming it
+ *
+ * @param   this  The reader
+ * @return        The next byte, -1 on error or
+ *                at end of input (errno is 0)
+ */
+static int
+reader_peek(Reader *this)
+{
+	for (;;) {
+		while (this->head < this->tail && IS_SPACE(this->buf[this->head]))
+			this->head++;
+		if (this->head < this->tail)
+			return this->buf[this->head];
+		errno = 0;
+		if (reader_fill(this) <= 0)
+			return -1;
+	}
+}
+
+
+/**
+ * Reads an integer from the input
+ *
+ * @param   this   The reader
+ * @param   cellp  Output parameter for the integer
+ * @return         0 on success, -1 on error
+ */
+static int
+reader_cell(Reader *this, Cell *cellp)
+{
+	size_t end;
+
+	if (reader_peek(this) < 0) {
+		if (!errno)
+			errno = EINVAL;
+		return -1;
+	}
+	for (end = this->head;; end++) {
+		if (end == this->tail) {
+			end -= this->head;
+			if (reader_fill(this) < 0)
+				return -1;
+			end += this->head;
+			if (end == this->tail)
+				break;
+		}
+		if (IS_SPACE(this->buf[end]))
+			break;
+		if (end - this->head > TOKEN_MAX) {
+			errno = EINVAL;
+			return -1;
+		}
+	}
+
+	if (!matrix_parse_cell((const char *)&this->buf[this->head], (const char *)&this->buf[end], cellp))
+		return -1;
+	this->head = end;
+	return 0;
+}
+
+
+/**
+ * Reads bytes from the input
+ *
+ * @param   this  The reader
+ * @param   buf   Output buffer, `NULL` to discard the bytes
+ * @param   size  The number of bytes to read
+ * @return        0 on success, -1 on error
+ */
+static int
+reader_bytes(Reader *this, unsigned char *buf, size_t size)
+{
+	size_t n;
+	ssize_t r;
+
+	while (size) {
+		if (this->head == this->tail) {
+			if ((r = reader_fill(this)) <= 0) {
+				if (!r)
+					errno = EINVAL;
+				return -1;
+			}
+		}
+		n = this->tail - this->head;
+		n = n < size ? n : size;
+		if (buf) {
+			memcpy(buf, &this->buf[this->head], n);
+			buf += n;
+		}
+		this->head += n;
+		size -= n;
+	}
+	return 0;
+}
+
+
+/**
+ * Reads a binary frame: a binary matrix file, see `matrix_map`,
+ * that ends after the padding of the last row
+ *
+ * @param   this    The stream
+ * @param   matrix  Output parameter for the table
+ * @return          0 on success, -1 on error
+ */
+static int
+read_binary(Stream *this, Matrix *matrix)
+{
+	unsigned char header_data[MATRIX_HEADER_SIZE];
+	MatrixHeader header;
+	void *row;
+	size_t i;
+
+	if (reader_bytes(&this->reader, header_data, sizeof(header_data)) ||
+	    matrix_parse_header(&header, header_data))
+		return -1;
+	if (header.n > header.m) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (reader_bytes(&this->reader, NULL, header.offset - MATRIX_HEADER_SIZE) ||
+	    matrix_resize(matrix, header.n, header.m))
+		return -1;
+
+	if (header.row_size > this->row_size) {
+		if (!(row = realloc(this->row, header.row_size)))
+			return -1;
+		this->row = row;
+		this->row_size = header.row_size;
+	}
+
+	for (i = 0; i < header.n; i++) {
+		if (reader_bytes(&this->reader, this->row, header.row_size))
+			return -1;
+		matrix_decode_row(&header, matrix->rows[i], this->row);
+		if (reader_bytes(&this->reader, NULL, header.stride - header.row_size))
+			return -1;
+	}
+	return 0;
+}
+
+
+/**
+ * Reads a text frame: the height and the width
+ * of the table followed by its cells, row by row
+ *
+ * @param   this    The stream
+ * @param   matrix  Output parameter for the table
+ * @return          0 on success, -1 on error
+ */
+static int
+read_text(Stream *this, Matrix *matrix)
+{
+	Cell n, m;
+	size_t i, j;
+
+	if (reader_cell(&this->reader, &n) || reader_cell(&this->reader, &m))
+		return -1;
+	if (n < 0 || m < 0 || n > m) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (matrix_resize(matrix, (size_t)n, (size_t)m))
+		return -1;
+
+	for (i = 0; i < matrix->n; i++)
+		for (j = 0; j < matrix->m; j++)
+			if (reader_cell(&this->reader, &matrix->rows[i][j]))
+				return -1;
+	return 0;
+}
+
+
+/**
+ * Deallocates the solver's workspace
+ *
+ * @param  this  The stream
+ */
+static void
+release_workspace(Stream *this)
+{
+	if (this->workspace && this->allocator)
+		this->allocator->deallocate(this->allocator->data, this->workspace, this->workspace_size, sizeof(Cell));
+	else
+		free(this->workspace);
+	this->workspace = NULL;
+	this->workspace_size = 0;
+}
+
+
+/**
+ * Makes sure the solver's workspace has room for a problem,
+ * it is only reallocated when it is too small
+ *
+ * @param   this  The stream
+ * @param   size  The number of bytes needed
+ * @return        0 on success, -1 on error
+ */
+static int
+reserve_workspace(Stream *this, size_t size)
+{
+	if (!size) {
+		errno = ENOMEM;
+		return -1;
+	}
+	if (size <= this->workspace_size)
+		return 0;
+
+	release_workspace(this);
+	if (this->allocator)
+		this->workspace = this->allocator->allocate(this->allocator->data, size, sizeof(Cell));
+	else
+		this->workspace = malloc(size);
+	if (!this->workspace) {
+		errno = ENOMEM;
+		return -1;
+	}
+	this->workspace_size = size;
+	return 0;
+}
+
+
+/**
+ * Copies an assignment into a slot, so that the
+ * workspace can be reused before it is written
+ *
+ * @param   slot    The slot
+ * @param   result  The result of the problem in the slot
+ * @return          0 on success, -1 on error
+ */
+static int
+keep_result(Slot *slot, const KuhnResult *result)
+{
+	KuhnIndex *col_of_row;
+	size_t n = slot->matrix.n;
+
+	if (n > slot->col_of_row_size) {
+		if (!(col_of_row = realloc(slot->col_of_row, n * sizeof(*col_of_row))))
+			return -1;
+		slot->col_of_row = col_of_row;
+		slot->col_of_row_size = n;
+	}
+	if (n)
+		memcpy(slot->col_of_row, result->col_of_row, n * sizeof(*slot->col_of_row));
+	slot->cost = result->cost;
+	return 0;
+}
+
+
+/**
+ * The first stage of the pipeline, reads problems into free slots
+ *
+ * @param   data  The stream
+ * @return        `NULL`
+ */
+static void *
+reader_thread(void *data)
+{
+	Stream *this = data;
+	Matrix *matrix;
+	Boolean failed;
+	int c, error = 0;
+
+	for (;;) {
+		pthread_mutex_lock(&this->lock);
+		while (this->read - this->written == STREAM_SLOTS && !this->failed)
+			pthread_cond_wait(&this->cond, &this->lock);
+		failed = this->failed;
+		matrix = &this->slots[this->read % STREAM_SLOTS].matrix;
+		pthread_mutex_unlock(&this->lock);
+		if (failed)
+			break;
+
+		if ((c = reader_peek(&this->reader)) < 0) {
+			error = errno;
+			break;
+		}
+		if (c == MATRIX_MAGIC[0] ? read_binary(this, matrix) : read_text(this, matrix)) {
+			error = errno ? errno : EINVAL;
+			break;
+		}
+
+		pthread_mutex_lock(&this->lock);
+		this->read++;
+		pthread_cond_broadcast(&this->cond);
+		pthread_mutex_unlock(&this->lock);
+	}
+
+	pthread_mutex_lock(&this->lock);
+	this->input_done = 1;
+	this->read_error = error;
+	pthread_cond_broadcast(&this->cond);
+	pthread_mutex_unlock(&this->lock);
+	return NULL;
+}
+
+
+/**
+ * The last stage of the pipeline, writes solved problems' results
+ *
+ * @param   data  The stream
+ * @return        `NULL`
+ */
+static void *
+writer_thread(void *data)
+{
+	Stream *this = data;
+	Slot *slot;
+	int r;
+
+	for (;;) {
+		pthread_mutex_lock(&this->lock);
+		while (this->written == this->solved && !this->solve_done)
+			pthread_cond_wait(&this->cond, &this->lock);
+		if (this->written == this->solved) {
+			pthread_mutex_unlock(&this->lock);
+			break;
+		}
+		slot = &this->slots[this->written % STREAM_SLOTS];
+		pthread_mutex_unlock(&this->lock);
+
+		r = (this->binary_output ? assignment_write_binary : assignment_write_text)
+		        (this->output, slot->col_of_row, slot->matrix.n, slot->cost);
+
+		pthread_mutex_lock(&this->lock);
+		if (r) {
+			this->failed = 1;
+			this->write_error = errno;
+		} else {
+			this->written++;
+		}
+		pthread_cond_broadcast(&this->cond);
+		pthread_mutex_unlock(&this->lock);
+		if (r)
+			break;
+	}
+	return NULL;
+}
+
+
+int
+stream_run(int fd, FILE *output, const KuhnOptions *options, long int budget, Boolean binary_output)
+{
+	Stream *this;
+	KuhnOptions opts = *options;
+	KuhnResult result;
+	struct timespec deadline;
+	pthread_t reader, writer;
+	Slot *slot;
+	size_t i;
+	int r, error = 0;
+
+	if (!(this = calloc(1, sizeof(*this))))
+		return -1;
+	this->reader.fd = fd;
+	this->allocator = options->allocator;
+	this->output = output;
+	this->binary_output = binary_output;
+
+	pthread_mutex_init(&this->lock, NULL);
+	pthread_cond_init(&this->cond, NULL);
+	if ((errno = pthread_create(&reader, NULL, reader_thread, this)))
+		goto fail;
+	if ((errno = pthread_create(&writer, NULL, writer_thread, this))) {
+		pthread_mutex_lock(&this->lock);
+		this->failed = 1;
+		pthread_cond_broadcast(&this->cond);
+		pthread_mutex_unlock(&this->lock);
+		pthread_join(reader, NULL);
+		goto fail;
+	}
+
+	/* The middle stage, solving, runs in the calling thread */
+	for (;;) {
+		pthread_mutex_lock(&this->lock);
+		while (this->solved == this->read && !this->input_done && !this->failed)
+			pthread_cond_wait(&this->cond, &this->lock);
+		if (this->solved == this->read || this->failed) {
+			pthread_mutex_unlock(&this->lock);
+			break;
+		}
+		slot = &this->slots[this->solved % STREAM_SLOTS];
+		pthread_mutex_unlock(&this->lock);
+
+		if (budget >= 0) {
+			clock_gettime(CLOCK_MONOTONIC, &deadline);
+			deadline.tv_sec  += budget / 1000;
+			deadline.tv_nsec += budget % 1000 * 1000000L;
+			if (deadline.tv_nsec >= 1000000000L) {
+				deadline.tv_sec  += 1;
+				deadline.tv_nsec -= 1000000000L;
+			}
+			opts.deadline = &deadline;
+		}
+		r = reserve_workspace(this, kuhn_workspace_size(slot->matrix.n, slot->matrix.m));
+		if (!r)
+			r = kuhn_solve_in(slot->matrix.n, slot->matrix.m, slot->matrix.rows, &opts,
+			                  this->workspace, this->workspace_size, &result);
+		if (!r)
+			r = keep_result(slot, &result);
+		if (r)
+			error = errno;
+		else if (!result.optimal)
+			fprintf(stderr, "Problem %zu: the deadline was reached, the optimal sum is bounded by %li\n",
+			        this->solved + 1, result.lower_bound);
+
+		pthread_mutex_lock(&this->lock);
+		if (r)
+			this->failed = 1;
+		else
+			this->solved++;
+		pthread_cond_broadcast(&this->cond);
+		pthread_mutex_unlock(&this->lock);
+		if (r)
+			break;
+	}
+
+	pthread_mutex_lock(&this->lock);
+	this->solve_done = 1;
+	pthread_cond_broadcast(&this->cond);
+	pthread_mutex_unlock(&this->lock);
+	pthread_join(writer, NULL);
+
+	/* The reader cannot be interrupted while it is waiting for
+	 * input, so after a failure it is left for exit(3) to stop */
+	if (!this->failed)
+		pthread_join(reader, NULL);
+	else if (!error)
+		error = this->write_error;
+	if (!error)
+		error = this->read_error;
+
+	if (this->failed)
+		return errno = error, -1;
+
+	for (i = 0; i < STREAM_SLOTS; i++) {
+		matrix_destroy(&this->slots[i].matrix);
+		free(this->slots[i].col_of_row);
+	}
+	release_workspace(this);
+	free(this->row);
+	pthread_cond_destroy(&this->cond);
+	pthread_mutex_destroy(&this->lock);
+	free(this);
+	if (error)
+		return errno = error, -1;
+	return 0;
+
+fail:
+	error = errno;
+	pthread_cond_destroy(&this->cond);
+	pthread_mutex_destroy(&this->lock);
+	free(this);
+	errno = error;
+	return -1;
+}
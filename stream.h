@@ -0,0 +1,53 @@
+/**
+ * 𝓞(n³) implementation of the Hungarian algorithm
+ * 
+ * Copyright (C) 2011, 2014, 2020  Mattias Andrée
+ * 
+ * This program is free software. It comes without any warranty, to
+ * the extent permitted by applicable law. You can redistribute it
+ * and/or modify it under the terms of the Do What The Fuck You Want
+ * To Public License, Version 2, as published by Sam Hocevar. See
+ * http://sam.zoy.org/wtfpl/COPYING for more details.
+ */
+
+
+#ifndef STREAM_H
+#define STREAM_H
+
+
+#include "matrix.h"
+
+
+
+/**
+ * Solves a stream of problems, reading them from a file descriptor
+ * and writing each result, in the format of `assignment_write_text`
+ * or `assignment_write_binary`, before the input ends
+ *
+ * Each problem is either a binary matrix file, see `matrix_map`,
+ * whose last row is padded to the stride like the others, or text:
+ * the height and width of the table followed by its cells, row by
+ * row; the format is recognised by the first byte. Problems are
+ * read, solved, and written by three threads, so reading and
+ * writing overlap solving. The tables' memory is reused, and the
+ * problems are solved with `kuhn_solve_in` in one workspace, which
+ * only grows when a problem does not fit in it
+ *
+ * The problems that were read before an invalid problem was found
+ * are solved and written before the function fails. If the function
+ * fails in any other way, a thread may still be waiting for input,
+ * so the process should exit
+ *
+ * @param   fd             The input
+ * @param   output         The output
+ * @param   options        Options for `kuhn_solve_in`, the `deadline` is ignored,
+ *                         `allocator` is used for the workspace
+ * @param   budget         The time limit for each problem, in milliseconds,
+ *                         or -1 for no limit
+ * @param   binary_output  Whether to write binary results
+ * @return                 0 on success, -1 on error
+ */
+int stream_run(int fd, FILE *output, const KuhnOptions *options, long int budget, Boolean binary_output);
+
+
+#endif
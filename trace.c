@@ -0,0 +1,175 @@
+/**
+ * 𝓞(n³) implementation of the Hungarian algorithm
+ * 
+ * Copyright (C) 2011, 2014, 2020  Mattias Andrée
+ * 
+ * This program is free software. It comes without any warranty, to
+ * the extent permitted by applicable law. You can redistribute it
+ * and/or modify it under the terms of the Do What The Fuck You Want
+ * To Public License, Version 2, as published by Sam Hocevar. See
+ * http://sam.zoy.org/wtfpl/COPYING for more details.
+ */
+
+
+#include "common.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <unistd.h>
+
+
+/*
+ * The trace is written in the trace-event JSON format, as a
+ * single array of complete ("X") events, with timestamps in
+ * microseconds from when the trace was opened.
+ */
+
+
+/**
+ * Key for the calling thread's ID in traces
+ */
+static pthread_key_t thread_key;
+
+/**
+ * Creates `thread_key` once
+ */
+static pthread_once_t thread_key_once = PTHREAD_ONCE_INIT;
+
+/**
+ * The number of IDs given to threads so far
+ */
+static size_t thread_count = 0;
+
+/**
+ * Protects `thread_count`
+ */
+static pthread_mutex_t thread_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+struct kuhn_trace {
+	/**
+	 * The output file
+	 */
+	FILE *fp;
+
+	/**
+	 * Serialises writes from parallel phases
+	 */
+	pthread_mutex_t lock;
+
+	/**
+	 * The time the trace was opened, in nanoseconds
+	 */
+	uint_fast64_t origin;
+
+	/**
+	 * Whether no event has been written yet
+	 */
+	Boolean empty;
+
+	/**
+	 * Whether a write has failed
+	 */
+	Boolean failed;
+};
+
+
+uint_fast64_t
+kuhn_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint_fast64_t)ts.tv_sec * 1000000000 + (uint_fast64_t)ts.tv_nsec;
+}
+
+
+/**
+ * Creates `thread_key`
+ */
+static void
+create_thread_key(void)
+{
+	pthread_key_create(&thread_key, NULL);
+}
+
+
+/**
+ * Gets the ID of the calling thread, the first thread to write a
+ * span gets 1, the next 2, and so on, for all traces in the process
+ * 
+ * @return  The thread's ID
+ */
+static size_t
+trace_thread(void)
+{
+	size_t tid;
+
+	pthread_once(&thread_key_once, create_thread_key);
+	tid = (size_t)(uintptr_t)pthread_getspecific(thread_key);
+	if (!tid) {
+		pthread_mutex_lock(&thread_lock);
+		tid = ++thread_count;
+		pthread_mutex_unlock(&thread_lock);
+		pthread_setspecific(thread_key, (void *)(uintptr_t)tid);
+	}
+
+	return tid;
+}
+
+
+void
+trace_span(KuhnTrace *this, const char *name, uint_fast64_t start, uint_fast64_t end)
+{
+	size_t tid = trace_thread();
+
+	start -= this->origin;
+	end -= this->origin;
+
+	pthread_mutex_lock(&this->lock);
+	if (fprintf(this->fp, "%s\n{\"name\":\"%s\",\"cat\":\"kuhn\",\"ph\":\"X\",\"pid\":%li,\"tid\":%zu,"
+	            "\"ts\":%lu.%03lu,\"dur\":%lu.%03lu}", this->empty ? "" : ",", name, (long int)getpid(), tid,
+	            (unsigned long int)(start / 1000), (unsigned long int)(start % 1000),
+	            (unsigned long int)((end - start) / 1000), (unsigned long int)((end - start) % 1000)) < 0)
+		this->failed = 1;
+	this->empty = 0;
+	pthread_mutex_unlock(&this->lock);
+}
+
+
+KuhnTrace *
+kuhn_trace_open(const char *path)
+{
+	KuhnTrace *this = malloc(sizeof(*this));
+	if (!this)
+		return NULL;
+
+	if (!(this->fp = fopen(path, "w"))) {
+		free(this);
+		return NULL;
+	}
+	pthread_mutex_init(&this->lock, NULL);
+	this->origin = kuhn_now();
+	this->empty = 1;
+	this->failed = fputs("{\"traceEvents\":[", this->fp) < 0;
+
+	return this;
+}
+
+
+int
+kuhn_trace_close(KuhnTrace *this)
+{
+	int saved_errno, ret;
+
+	if (!this)
+		return 0;
+
+	if (fputs("\n]}\n", this->fp) < 0)
+		this->failed = 1;
+	ret = (fclose(this->fp) || this->failed) ? -1 : 0;
+	saved_errno = errno;
+	pthread_mutex_destroy(&this->lock);
+	free(this);
+	errno = saved_errno;
+	return ret;
+}
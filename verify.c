@@ -0,0 +1,92 @@
+/**
+ * 𝓞(n³) implementation of the Hungarian algorithm
+ * 
+ * Copyright (C) 2011, 2014, 2020  Mattias Andrée
+ * 
+ * This program is free software. It comes without any warranty, to
+ * the extent permitted by applicable law. You can redistribute it
+ * and/or modify it under the terms of the Do What The Fuck You Want
+ * To Public License, Version 2, as published by Sam Hocevar. See
+ * http://sam.zoy.org/wtfpl/COPYING for more details.
+ */
+
+
+#include "common.h"
+
+
+/*
+ * The linear programming dual of the assignment problem with
+ * n ≤ m is to maximise the sum of all potentials, subject to
+ * u[i] + v[j] ≤ c[i][j] for every cell and v[j] ≤ 0 for every
+ * column (since columns may be left unassigned). An assignment
+ * and potentials that are both feasible are optimal if and only
+ * if every assigned cell is tight and every column with a
+ * non-zero potential is assigned.
+ *
+ * For a maximum, all inequalities are reversed, which is
+ * the same as the above for the negated table and potentials.
+ */
+
+
+/**
+ * Verifies that an assignment is optimal
+ *
+ * @param   n              The height of the table
+ * @param   m              The width of the table
+ * @param   table          The original costs
+ * @param   col_of_row     The assignment, the column assigned to each row
+ * @param   row_potential  The potential of each row
+ * @param   col_potential  The potential of each column
+ * @param   sign           1 for a minimum, -1 for a maximum
+ * @return                 1 if the assignment is proven
+ *                         to be optimal, 0 otherwise
+ */
+static Boolean
+verify(size_t n, size_t m, Cell *const *table, const KuhnIndex *col_of_row,
+       const Cell *row_potential, const Cell *col_potential, Cell sign)
+{
+	const Cell *u = row_potential, *v = col_potential, *ti;
+	Boolean *assigned, ok = 0;
+	size_t i, j, col;
+
+	if (n > m || !(assigned = calloc(m + !m, sizeof(Boolean))))
+		return 0;
+
+	for (i = 0; i < n; i++) {
+		if ((col = col_of_row[i]) >= m || assigned[col])
+			goto out;
+		assigned[col] = 1;
+
+		ti = table[i];
+		for (j = 0; j < m; j++)
+			if (sign * (ti[j] - u[i] - v[j]) < 0)
+				goto out;
+		if (ti[col] - u[i] - v[col])
+			goto out;
+	}
+
+	for (j = 0; j < m; j++)
+		if (sign * v[j] > 0 || (v[j] && !assigned[j]))
+			goto out;
+
+	ok = 1;
+out:
+	free(assigned);
+	return ok;
+}
+
+
+Boolean
+kuhn_verify(size_t n, size_t m, Cell *const *table, const KuhnIndex *col_of_row,
+            const Cell *row_potential, const Cell *col_potential)
+{
+	return verify(n, m, table, col_of_row, row_potential, col_potential, 1);
+}
+
+
+Boolean
+kuhn_verify_max(size_t n, size_t m, Cell *const *table, const KuhnIndex *col_of_row,
+                const Cell *row_potential, const Cell *col_potential)
+{
+	return verify(n, m, table, col_of_row, row_potential, col_potential, -1);
+}